@@ -0,0 +1,227 @@
+#include <Cafe/TextUtils/Format.h>
+#include <Cafe/TextUtils/FormatArgs.h>
+#include <Cafe/TextUtils/FormatBatch.h>
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <string>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+using namespace Cafe;
+using namespace TextUtils;
+
+namespace
+{
+	constexpr auto Utf8 = Encoding::CodePage::Utf8;
+
+	// 不预留空间的格式化，作为比较的基准
+	template <typename Format, typename... Args>
+	Encoding::String<Utf8> FormatWithoutReserve(Format const& format, Args const&... args)
+	{
+		Encoding::String<Utf8> resultStr;
+		FormatStringWithReceiver([&](auto const& result) { resultStr.Append(result); }, format,
+		                         args...);
+		return resultStr;
+	}
+
+	template <typename... Args>
+	std::string SnprintfString(const char* format, Args... args)
+	{
+		char buffer[256];
+		const auto size = std::snprintf(buffer, sizeof(buffer), format, args...);
+		return std::string(buffer, static_cast<std::size_t>(size));
+	}
+} // namespace
+
+TEST_CASE("Cafe.TextUtils.Format benchmark", "[TextUtils][Format][Benchmark]")
+{
+	SECTION("Integers")
+	{
+		BENCHMARK("FormatString auto index")
+		{
+			return FormatString(CAFE_UTF8_SV("${}: ${:x}, ${}"), 42, 255, -7);
+		};
+
+		BENCHMARK("FormatString explicit index")
+		{
+			return FormatString(CAFE_UTF8_SV("${0}: ${1:x}, ${2}"), 42, 255, -7);
+		};
+
+		BENCHMARK("FormatString compiled format")
+		{
+			return FormatString(CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}: ${:x}, ${}")), 42, 255, -7);
+		};
+
+		BENCHMARK("FormatTo stack buffer")
+		{
+			std::array<char8_t, 64> buffer;
+			return FormatTo(buffer, CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}: ${:x}, ${}")), 42, 255,
+			                -7)
+			    .WrittenSize;
+		};
+
+		BENCHMARK("snprintf")
+		{
+			return SnprintfString("%d: %x, %d", 42, 255, -7);
+		};
+
+#ifdef __cpp_lib_format
+		BENCHMARK("std::format")
+		{
+			return std::format("{}: {:x}, {}", 42, 255, -7);
+		};
+#endif
+	}
+
+	SECTION("Floating")
+	{
+		BENCHMARK("FormatString shortest")
+		{
+			return FormatString(CAFE_UTF8_SV("${} ${}"), 3.14159, -1e-10);
+		};
+
+		BENCHMARK("FormatString fixed")
+		{
+			return FormatString(CAFE_UTF8_SV("${:f.3} ${:f.3}"), 3.14159, -1e-10);
+		};
+
+		BENCHMARK("snprintf")
+		{
+			return SnprintfString("%.17g %.17g", 3.14159, -1e-10);
+		};
+
+#ifdef __cpp_lib_format
+		BENCHMARK("std::format")
+		{
+			return std::format("{} {}", 3.14159, -1e-10);
+		};
+#endif
+	}
+
+	SECTION("Mixed")
+	{
+		const auto name = EncodeFromNarrow<Utf8>("benchmark");
+
+		BENCHMARK("FormatString")
+		{
+			return FormatString(CAFE_UTF8_SV("[${}] ${}: ${} (${:f.2}%)"), name, 12345, 1.5,
+			                    99.5);
+		};
+
+		BENCHMARK("VFormatString")
+		{
+			return VFormatString(CAFE_UTF8_SV("[${}] ${}: ${} (${:f.2}%)"),
+			                     MakeFormatArgs<Utf8>(name, 12345, 1.5, 99.5));
+		};
+
+		BENCHMARK("snprintf")
+		{
+			return SnprintfString("[%s] %d: %g (%.2f%%)", "benchmark", 12345, 1.5, 99.5);
+		};
+
+#ifdef __cpp_lib_format
+		BENCHMARK("std::format")
+		{
+			return std::format("[{}] {}: {} ({:.2f}%)", "benchmark", 12345, 1.5, 99.5);
+		};
+#endif
+	}
+
+	SECTION("Long output")
+	{
+		const auto longStr = EncodeFromNarrow<Utf8>(std::string(1024, 'a'));
+		const auto longView = longStr.GetView();
+		constexpr auto format = CAFE_UTF8_SV("${0}${1}${0}${1}${0}${1}${0}${1}${2}");
+
+		BENCHMARK("Without reserve")
+		{
+			return FormatWithoutReserve(format, longView, 123456789, -1);
+		};
+
+		BENCHMARK("With reserve")
+		{
+			return FormatString(format, longView, 123456789, -1);
+		};
+
+		const FormatTemplate formatTemplate{ format };
+		BENCHMARK("Runtime template")
+		{
+			return FormatString(formatTemplate, longView, 123456789, -1);
+		};
+	}
+
+	SECTION("Ranges")
+	{
+		std::vector<int> ids(1000);
+		for (std::size_t i = 0; i < ids.size(); ++i)
+		{
+			ids[i] = static_cast<int>(i * 7919);
+		}
+
+		BENCHMARK("Joined by hand")
+		{
+			Encoding::String<Utf8> joined;
+			for (std::size_t i = 0; i < ids.size(); ++i)
+			{
+				if (i)
+				{
+					joined.Append(CAFE_UTF8_SV(", "));
+				}
+				joined.Append(FormatString(CAFE_UTF8_SV("${:x}"), ids[i]).GetView());
+			}
+			return FormatString(CAFE_UTF8_SV("ids: ${}"), joined);
+		};
+
+		BENCHMARK("Range argument")
+		{
+			return FormatString(CAFE_UTF8_SV("ids: ${:x;sep=, }"), ids);
+		};
+	}
+
+	SECTION("Transcoding")
+	{
+		constexpr auto format = CAFE_UTF8_SV("[${}] 名称: ${}, 数值: ${:x} (${:f.2}%)");
+		const auto name = CAFE_UTF8_SV("基准测试");
+
+		BENCHMARK("FormatString then EncodeTo")
+		{
+			return EncodeTo<Encoding::CodePage::Utf16LittleEndian>(
+			    FormatString(format, name, 12345, 255, 99.5).GetView());
+		};
+
+		BENCHMARK("FormatStringAs")
+		{
+			return FormatStringAs<Encoding::CodePage::Utf16LittleEndian>(format, name, 12345, 255,
+			                                                             99.5);
+		};
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.FormatBatch benchmark", "[TextUtils][Format][Benchmark]")
+{
+	std::vector<std::tuple<int, double, int>> rows;
+	for (int i = 0; i < 100000; ++i)
+	{
+		rows.emplace_back(i, i / 7.0, -i);
+	}
+	constexpr auto format = CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}\t${:f.3}\t${:x}\n"));
+
+	BENCHMARK("Serial")
+	{
+		Encoding::String<Utf8> result;
+		for (auto const& [a, b, c] : rows)
+		{
+			FormatStringWithReceiver(StringSink{ result }, format, a, b, c);
+		}
+		return result;
+	};
+
+	BENCHMARK("FormatBatch")
+	{
+		Encoding::String<Utf8> result;
+		FormatBatch(format, rows, StringSink{ result });
+		return result;
+	};
+}
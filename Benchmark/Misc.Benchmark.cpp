@@ -0,0 +1,189 @@
+#include <Cafe/TextUtils/CodePointIterator.h>
+#include <Cafe/TextUtils/ParallelEncode.h>
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <vector>
+
+using namespace Cafe;
+using namespace TextUtils;
+
+namespace
+{
+	// ASCII 与中文混合的文本
+	Encoding::String<Encoding::CodePage::Utf8> MakeMixedText()
+	{
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		for (std::size_t i = 0; i < 256; ++i)
+		{
+			result.Append(CAFE_UTF8_SV("The quick brown fox 测试文本 "));
+		}
+		return result;
+	}
+
+	// 仅包含 ASCII 字符的文本
+	Encoding::String<Encoding::CodePage::Utf8> MakeAsciiText()
+	{
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		for (std::size_t i = 0; i < 256; ++i)
+		{
+			result.Append(CAFE_UTF8_SV("The quick brown fox jumps over the lazy dog. "));
+		}
+		return result;
+	}
+
+	// 将 text 中约 invalidPercent% 的字节替换为无效的 0xFF
+	std::vector<char8_t> MakeInvalidText(Encoding::StringView<Encoding::CodePage::Utf8> const& text,
+	                                     std::size_t invalidPercent)
+	{
+		const auto span = text.GetTrimmedSpan();
+		std::vector<char8_t> result(span.begin(), span.end());
+		for (std::size_t i = 0; i < result.size(); ++i)
+		{
+			if ((i * 37 + 11) % 100 < invalidPercent)
+			{
+				result[i] = 0xFF;
+			}
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("Cafe.TextUtils.Misc benchmark", "[TextUtils][Misc][Benchmark]")
+{
+	const auto utf8Text = MakeMixedText();
+	const auto utf16Text = EncodeTo<Encoding::CodePage::Utf16LittleEndian>(utf8Text.GetView());
+	const auto utf32Text = EncodeTo<Encoding::CodePage::Utf32LittleEndian>(utf8Text.GetView());
+	const auto asciiText = MakeAsciiText();
+	const auto asciiUtf16Text =
+	    EncodeTo<Encoding::CodePage::Utf16LittleEndian>(asciiText.GetView());
+
+	SECTION("EncodeTo")
+	{
+		BENCHMARK("UTF-8 to UTF-16")
+		{
+			return EncodeTo<Encoding::CodePage::Utf16LittleEndian>(utf8Text.GetView());
+		};
+
+		BENCHMARK("UTF-8 to UTF-32")
+		{
+			return EncodeTo<Encoding::CodePage::Utf32LittleEndian>(utf8Text.GetView());
+		};
+
+		BENCHMARK("UTF-16 to UTF-8")
+		{
+			return EncodeTo<Encoding::CodePage::Utf8>(utf16Text.GetView());
+		};
+
+		BENCHMARK("UTF-32 to UTF-8")
+		{
+			return EncodeTo<Encoding::CodePage::Utf8>(utf32Text.GetView());
+		};
+
+		BENCHMARK("UTF-16 to UTF-32")
+		{
+			return EncodeTo<Encoding::CodePage::Utf32LittleEndian>(utf16Text.GetView());
+		};
+
+		BENCHMARK("ASCII UTF-8 to UTF-16")
+		{
+			return EncodeTo<Encoding::CodePage::Utf16LittleEndian>(asciiText.GetView());
+		};
+
+		BENCHMARK("ASCII UTF-16 to UTF-8")
+		{
+			return EncodeTo<Encoding::CodePage::Utf8>(asciiUtf16Text.GetView());
+		};
+	}
+
+	SECTION("CodePointIterator")
+	{
+		const auto traverse = []<Encoding::CodePage::CodePageType CodePageValue>(
+		                          Encoding::String<CodePageValue> const& str) {
+			using CodePageIterator = CodePointIterator<CodePageValue>;
+			Encoding::CodePointType sum{};
+			for (CodePageIterator iter{ str.GetView().GetSpan() }, end{}; iter != end; ++iter)
+			{
+				// 定长编码直接得到码点，变长编码得到码点及宽度
+				const auto value = *iter;
+				if constexpr (requires { value.first; })
+				{
+					sum += value.first;
+				}
+				else
+				{
+					sum += value;
+				}
+			}
+			return sum;
+		};
+
+		BENCHMARK("UTF-8")
+		{
+			return traverse(utf8Text);
+		};
+
+		BENCHMARK("UTF-16")
+		{
+			return traverse(utf16Text);
+		};
+
+		BENCHMARK("UTF-32")
+		{
+			return traverse(utf32Text);
+		};
+	}
+
+	SECTION("EncodeToWithReplacement")
+	{
+		for (const auto invalidPercent : { 0, 1, 50 })
+		{
+			const auto invalidText = MakeInvalidText(utf8Text.GetView(), invalidPercent);
+			const Encoding::StringView<Encoding::CodePage::Utf8> view{ std::span<const char8_t>(
+				invalidText) };
+
+			BENCHMARK("UTF-8 to UTF-16, " + std::to_string(invalidPercent) + "% invalid")
+			{
+				return EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+				    view, ReplacementOption{});
+			};
+
+			BENCHMARK("UTF-8 to UTF-8, " + std::to_string(invalidPercent) + "% invalid")
+			{
+				return EncodeToWithReplacement<Encoding::CodePage::Utf8>(view, ReplacementOption{});
+			};
+		}
+	}
+
+	SECTION("EncodeToParallel")
+	{
+		Encoding::String<Encoding::CodePage::Utf8> largeText;
+		for (std::size_t i = 0; i < 256; ++i)
+		{
+			largeText.Append(utf8Text.GetView());
+		}
+		const auto largeUtf16Text =
+		    EncodeTo<Encoding::CodePage::Utf16LittleEndian>(largeText.GetView());
+		constexpr ParallelEncodeOption option{ 0, std::size_t{ 1 } << 16 };
+
+		BENCHMARK("UTF-8 to UTF-16, serial")
+		{
+			return EncodeTo<Encoding::CodePage::Utf16LittleEndian>(largeText.GetView());
+		};
+
+		BENCHMARK("UTF-8 to UTF-16, parallel")
+		{
+			return EncodeToParallel<Encoding::CodePage::Utf16LittleEndian>(largeText.GetView(),
+			                                                               option);
+		};
+
+		BENCHMARK("UTF-16 to UTF-8, serial")
+		{
+			return EncodeTo<Encoding::CodePage::Utf8>(largeUtf16Text.GetView());
+		};
+
+		BENCHMARK("UTF-16 to UTF-8, parallel")
+		{
+			return EncodeToParallel<Encoding::CodePage::Utf8>(largeUtf16Text.GetView(), option);
+		};
+	}
+}
@@ -0,0 +1,61 @@
+#include <Cafe/Io/Streams/MemoryStream.h>
+#include <Cafe/TextUtils/TextReader.h>
+#include <Cafe/TextUtils/TextWriter.h>
+#include <catch2/catch_all.hpp>
+
+using namespace Cafe;
+using namespace Encoding;
+using namespace TextUtils;
+using namespace Io;
+
+TEST_CASE("Cafe.TextUtils.StreamHelpers benchmark", "[TextUtils][StreamHelpers][Benchmark]")
+{
+	constexpr std::size_t LineCount = 1000;
+	constexpr auto Line = CAFE_UTF8_SV("The quick brown fox 测试文本");
+
+	BENCHMARK("TextWriter::WriteLine")
+	{
+		MemoryStream stream;
+		TextWriter<CodePage::Utf8> writer{ &stream };
+		for (std::size_t i = 0; i < LineCount; ++i)
+		{
+			writer.WriteLine(Line);
+		}
+		writer.Flush();
+		return stream.GetPosition();
+	};
+
+	BENCHMARK("TextWriter::WriteLine with format")
+	{
+		MemoryStream stream;
+		TextWriter<CodePage::Utf8> writer{ &stream };
+		for (std::size_t i = 0; i < LineCount; ++i)
+		{
+			writer.WriteLine(CAFE_UTF8_SV("${}: ${}"), i, Line);
+		}
+		writer.Flush();
+		return stream.GetPosition();
+	};
+
+	MemoryStream input;
+	{
+		TextWriter<CodePage::Utf8> writer{ &input };
+		for (std::size_t i = 0; i < LineCount; ++i)
+		{
+			writer.WriteLine(Line);
+		}
+		writer.Flush();
+	}
+
+	BENCHMARK("TextReader::ReadLine")
+	{
+		input.SeekFromBegin(0);
+		TextReader<CodePage::Utf8> reader{ &input };
+		std::size_t totalSize{};
+		for (std::size_t i = 0; i < LineCount; ++i)
+		{
+			totalSize += reader.ReadLine().GetSize();
+		}
+		return totalSize;
+	};
+}
@@ -2,669 +2,3624 @@
 
 #include <Cafe/Encoding/Strings.h>
 #include <Cafe/Misc/Math.h>
-#include <Cafe/Misc/NumericInterval.h>
 #include <Cafe/TextUtils/CodePointIterator.h>
+#include <Cafe/TextUtils/Config.h>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <ranges>
 #include <sstream>
+#include <tuple>
+#include <vector>
 
 namespace Cafe::TextUtils
 {
 	CAFE_DEFINE_GENERAL_EXCEPTION(FormatException, ErrorHandling::CafeException);
 
-	/// @return 结果及消费的编码单元数量
-	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
-	constexpr std::pair<std::uintmax_t, std::size_t>
-	AsciiToNumber(Encoding::StringView<CodePageValue, Extent> const& str, std::size_t base = 10)
+	/// @brief  格式化错误
+	enum class FormatErrorCode
 	{
-		assert(2 <= base && base <= 36);
+		Success,
+		InvalidFormatString,
+		InvalidOption,
+		BaseRespecified,
+		PrecisionTooLarge,
+		IndexOutOfRange,
+		BufferTooSmall,
+	};
 
-		const Core::Misc::NumericInterval<Encoding::CodePointType> DecimalCodePointValue{
-			{ '0', true },
-			{ static_cast<Encoding::CodePointType>('0' + std::min(base, std::size_t{ 10 })), false }
-		};
-		// 若 base 不大于 10 时将会是空集，不需要特殊处理，下同
-		const Core::Misc::NumericInterval<Encoding::CodePointType> OverDecimalCodePointValue{
-			{ 'A', true }, { static_cast<Encoding::CodePointType>('A' + base - 10), false }
-		};
-		const Core::Misc::NumericInterval<Encoding::CodePointType> OverDecimalCodePointValue2{
-			{ 'a', true }, { static_cast<Encoding::CodePointType>('a' + base - 10), false }
-		};
+	namespace Detail
+	{
+		constexpr auto GetFormatErrorMessage(FormatErrorCode code) noexcept
+		{
+			switch (code)
+			{
+			case FormatErrorCode::InvalidFormatString:
+				return Encoding::StringView<Encoding::CodePage::Utf8>{ CAFE_UTF8_SV(
+					"Invalid format string.") };
+			case FormatErrorCode::InvalidOption:
+				return Encoding::StringView<Encoding::CodePage::Utf8>{ CAFE_UTF8_SV(
+					"Invalid option.") };
+			case FormatErrorCode::BaseRespecified:
+				return Encoding::StringView<Encoding::CodePage::Utf8>{ CAFE_UTF8_SV(
+					"Base has been specified.") };
+			case FormatErrorCode::PrecisionTooLarge:
+				return Encoding::StringView<Encoding::CodePage::Utf8>{ CAFE_UTF8_SV(
+					"Precision is too large.") };
+			case FormatErrorCode::IndexOutOfRange:
+				return Encoding::StringView<Encoding::CodePage::Utf8>{ CAFE_UTF8_SV(
+					"Index out of range.") };
+			case FormatErrorCode::BufferTooSmall:
+				return Encoding::StringView<Encoding::CodePage::Utf8>{ CAFE_UTF8_SV(
+					"Buffer is too small.") };
+			default:
+				return Encoding::StringView<Encoding::CodePage::Utf8>{ CAFE_UTF8_SV(
+					"Unknown error.") };
+			}
+		}
+	} // namespace Detail
+
+	/// @brief  格式化出错时抛出 FormatException，为默认的策略
+	struct ThrowOnFormatErrorPolicy
+	{
+		static constexpr bool CheckFormat = true;
 
-		std::uintmax_t result{};
-		std::size_t resultAdvanceCount{};
-		CodePointIterator<CodePageValue> read{ str.GetSpan() };
-		const CodePointIterator<CodePageValue> end{};
-		for (; read != end; ++read)
+		[[noreturn]] static FormatErrorCode OnFormatError(FormatErrorCode code)
 		{
-			const auto [codePoint, advanceCount] = [&] {
-				if constexpr (Encoding::CodePage::CodePageTrait<CodePageValue>::IsVariableWidth)
-				{
-					return *read;
-				}
-				else
+			CAFE_THROW(FormatException, Detail::GetFormatErrorMessage(code));
+		}
+	};
+
+	/// @brief  格式化出错时停止格式化并返回错误码，已写出的结果不会被撤销
+	struct ReturnFormatErrorPolicy
+	{
+		static constexpr bool CheckFormat = true;
+
+		static constexpr FormatErrorCode OnFormatError(FormatErrorCode code) noexcept
+		{
+			return code;
+		}
+	};
+
+	/// @brief  假设格式串及格式化选项总是有效，省略不影响内存安全的检查
+	/// @remark 输入无效时不会产生未定义行为，但结果未指定，无法省略的检查失败时同样返回错误码
+	struct AssumeValidFormatPolicy
+	{
+		static constexpr bool CheckFormat = false;
+
+		static constexpr FormatErrorCode OnFormatError(FormatErrorCode code) noexcept
+		{
+			return code;
+		}
+	};
+
+	/// @brief  出错时不抛出异常的策略
+	template <typename ErrorPolicy>
+	concept NoexceptFormatErrorPolicy =
+	    noexcept(ErrorPolicy::OnFormatError(FormatErrorCode::InvalidOption));
+
+	struct AsciiToNumberResult
+	{
+		/// @brief  转换结果，溢出时为 std::uintmax_t 的最大值
+		std::uintmax_t Value;
+		/// @brief  消费的编码单元数量
+		std::size_t Size;
+		bool IsOverflow;
+	};
+
+	namespace Detail
+	{
+		/// @brief  解码开头的码点
+		/// @remark 由于 CodePointIterator 使用 mutable 成员缓存，部分编译器无法在编译期求值，
+		///         因此格式串分析使用本函数
+		/// @return 码点及消费的编码单元数量，编码失败时返回不可能匹配的码点并消费 1 个编码单元
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		constexpr std::pair<Encoding::CodePointType, std::size_t> DecodeFirstCodePoint(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType> const&
+		        span) noexcept
+		{
+			using Trait = Encoding::CodePage::CodePageTrait<CodePageValue>;
+			std::pair<Encoding::CodePointType, std::size_t> result{
+				std::numeric_limits<Encoding::CodePointType>::max(), 1
+			};
+			const auto receiver = [&](auto const& encodingResult) {
+				if constexpr (Encoding::GetEncodingResultCode<decltype(encodingResult)> ==
+				              Encoding::EncodingResultCode::Accept)
 				{
-					return std::pair{ *read, 1 };
+					if constexpr (Trait::IsVariableWidth)
+					{
+						result = { encodingResult.Result, encodingResult.AdvanceCount };
+					}
+					else
+					{
+						result.first = encodingResult.Result;
+					}
 				}
-			}();
-			if (DecimalCodePointValue.InBounds(codePoint))
+			};
+
+			if constexpr (Trait::IsVariableWidth)
 			{
-				result = result * base + (codePoint - '0');
+				Trait::ToCodePoint(span, receiver);
 			}
-			else if (OverDecimalCodePointValue.InBounds(codePoint))
+			else
 			{
-				result = result * base + (codePoint - 'A' + 10);
+				Trait::ToCodePoint(span[0], receiver);
 			}
-			else if (OverDecimalCodePointValue2.InBounds(codePoint))
+
+			return result;
+		}
+
+		/// @brief  在 ASCII 兼容编码的编码单元中查找指定的 ASCII 字符
+		/// @remark 由于多字节序列中不会出现 ASCII 范围内的编码单元，可直接按编码单元比较
+		/// @return 首个匹配的位置，未找到时返回编码单元数量
+		template <typename CharType>
+		std::size_t FindAsciiUnit(std::span<const CharType> const& units, char value) noexcept
+		{
+			assert(static_cast<unsigned char>(value) < 0x80);
+
+			if constexpr (sizeof(CharType) == 1)
 			{
-				result = result * base + (codePoint - 'a' + 10);
+				const auto found = std::memchr(units.data(), value, units.size());
+				return found ? static_cast<const CharType*>(found) - units.data() : units.size();
 			}
 			else
 			{
-				break;
+				std::size_t i{};
+#if CAFE_TEXTUTILS_HAS_SSE2
+				static_assert(sizeof(CharType) == 2 || sizeof(CharType) == 4);
+				// 每次比较 2 个 128 位寄存器
+				constexpr auto LaneCount = 2 * sizeof(__m128i) / sizeof(CharType);
+				const auto compare = [needle = sizeof(CharType) == 2 ? _mm_set1_epi16(value)
+				                                                     : _mm_set1_epi32(value)](
+				                         const CharType* ptr) {
+					const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+					return static_cast<unsigned>(_mm_movemask_epi8(
+					    sizeof(CharType) == 2 ? _mm_cmpeq_epi16(chunk, needle)
+					                          : _mm_cmpeq_epi32(chunk, needle)));
+				};
+				for (; i + LaneCount <= units.size(); i += LaneCount)
+				{
+					const auto mask = compare(units.data() + i) |
+					                  (compare(units.data() + i + LaneCount / 2) << 16);
+					if (mask)
+					{
+						return i + std::countr_zero(mask) / sizeof(CharType);
+					}
+				}
+#endif
+				for (; i < units.size(); ++i)
+				{
+					if (units[i] == static_cast<CharType>(value))
+					{
+						return i;
+					}
+				}
+				return units.size();
 			}
-			resultAdvanceCount += advanceCount;
 		}
 
-		return { result, resultAdvanceCount };
-	}
-
-	struct DefaultStringConverter
-	{
-		template <typename T, Encoding::CodePage::CodePageType CodePageValue,
-		          typename OutputReceiver>
-		static constexpr void ToString(T const& value,
-		                               Encoding::StringView<CodePageValue> const& formatOption,
-		                               OutputReceiver&& receiver)
+		/// @brief  获得 ASCII 字符表示的数字值，不是数字时返回不小于 36 的值
+		constexpr std::uint32_t GetDigitValue(std::uint32_t codePoint) noexcept
 		{
-			if constexpr (std::is_integral_v<T>)
-			{
-				IntegerToString(value, formatOption, std::forward<OutputReceiver>(receiver));
-			}
-			else if constexpr (std::is_floating_point_v<T>)
+			if (codePoint - '0' < 10)
 			{
-				FloatingToString(value, formatOption, std::forward<OutputReceiver>(receiver));
+				return codePoint - '0';
 			}
-			else if constexpr (Encoding::IsStringView<T> || Encoding::IsStaticString<T>)
+			if (codePoint - 'A' < 26)
 			{
-				std::forward<OutputReceiver>(receiver)(value.GetSpan());
+				return codePoint - 'A' + 10;
 			}
-			else if constexpr (Encoding::IsString<T>)
+			if (codePoint - 'a' < 26)
 			{
-				std::forward<OutputReceiver>(receiver)(value.GetView().GetSpan());
+				return codePoint - 'a' + 10;
 			}
-			else
+			return std::numeric_limits<std::uint32_t>::max();
+		}
+
+		/// @brief  将数字累加到 result 上
+		/// @return 是否溢出，溢出时 result 不变
+		constexpr bool AccumulateDigit(std::uintmax_t& result, std::uint32_t digit,
+		                               std::size_t base) noexcept
+		{
+			if (result > (std::numeric_limits<std::uintmax_t>::max() - digit) / base)
 			{
-				CAFE_THROW(FormatException, CAFE_UTF8_SV("Unformattable data."));
+				return true;
 			}
+			result = result * base + digit;
+			return false;
 		}
 
-	private:
-		template <typename T, Encoding::CodePage::CodePageType CodePageValue,
-		          typename OutputReceiver>
-		static constexpr void
-		IntegerToString(T value, Encoding::StringView<CodePageValue> const& formatOption,
-		                OutputReceiver&& receiver)
+		/// @brief  按小端序载入的 8 个字节是否均为 ASCII 十进制数字
+		constexpr bool IsEightDigits(std::uint64_t value) noexcept
 		{
-			// 若 value 是有符号数且是最小值，最后要补加 1
-			[[maybe_unused]] auto isSignedMin = false;
-			std::size_t base = 10;
-			auto baseSpecified = false;
-			auto useUppercase = false;
+			return ((value & 0xF0F0F0F0F0F0F0F0) |
+			        (((value + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+			       0x3333333333333333;
+		}
+
+		/// @brief  将按小端序载入的 8 个 ASCII 十进制数字转换为数值，首个数字位于最低字节
+		constexpr std::uint32_t ParseEightDigits(std::uint64_t value) noexcept
+		{
+			constexpr std::uint64_t Mask = 0x000000FF000000FF;
+			constexpr std::uint64_t Multiplier1 = 100 + (1000000ull << 32);
+			constexpr std::uint64_t Multiplier2 = 1 + (10000ull << 32);
+			value -= 0x3030303030303030;
+			// 相邻两位合并为 0 至 99 的值，再两两合并
+			value = value * 10 + (value >> 8);
+			value = ((value & Mask) * Multiplier1 + ((value >> 16) & Mask) * Multiplier2) >> 32;
+			return static_cast<std::uint32_t>(value);
+		}
 
-			// 解析格式化选项
-			CodePointIterator<CodePageValue> read{ formatOption.GetSpan() };
-			const CodePointIterator<CodePageValue> end{};
-			for (; read != end; ++read)
+		/// @brief  每次处理 8 个十进制数字，遇到非数字或可能溢出时停止，剩余部分交由逐个处理
+		/// @remark 仅用于小端序且编码单元不超过 2 字节的 ASCII 兼容编码，uintmax_t 至多容纳 20 位十进制数字，
+		///         因此每次处理更多数字并不能带来收益
+		/// @return 消费的编码单元数量
+		template <typename CharType>
+		std::size_t ParseDecimalSwar(std::span<const CharType> const& units,
+		                             std::uintmax_t& result) noexcept
+		{
+			static_assert(sizeof(CharType) <= 2 && std::endian::native == std::endian::little);
+
+			constexpr std::size_t ChunkSize = 8;
+			// 不大于此值时乘以 10^8 再加上 8 位数字必定不会溢出
+			constexpr auto SafeLimit =
+			    (std::numeric_limits<std::uintmax_t>::max() - 99999999) / 100000000;
+
+			std::size_t consumed{};
+			while (units.size() - consumed >= ChunkSize && result <= SafeLimit)
 			{
-				const auto item = *read;
-				switch (item.first)
+				std::uint64_t chunk;
+				if constexpr (sizeof(CharType) == 1)
 				{
-				case 'b':
-					if (baseSpecified)
-					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Base has been specified."));
-					}
-					base = 2;
-					baseSpecified = true;
-					break;
-				case 'o':
-					if (baseSpecified)
-					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Base has been specified."));
-					}
-					base = 8;
-					baseSpecified = true;
-					break;
-				case 'd':
-				case 'i':
-					if (baseSpecified)
-					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Base has been specified."));
-					}
-					baseSpecified = true;
-					break;
-				case 'x':
-					if (baseSpecified)
-					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Base has been specified."));
-					}
-					base = 16;
-					baseSpecified = true;
-					break;
-				case 'X':
-					if (baseSpecified)
+					std::memcpy(&chunk, units.data() + consumed, sizeof(chunk));
+				}
+				else
+				{
+					std::uint64_t low, high;
+					std::memcpy(&low, units.data() + consumed, sizeof(low));
+					std::memcpy(&high, units.data() + consumed + 4, sizeof(high));
+					if ((low | high) & 0xFF80FF80FF80FF80)
 					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Base has been specified."));
+						break;
 					}
-					base = 16;
-					useUppercase = true;
-					baseSpecified = true;
+					// 将 4 个 16 位通道压缩为 4 个字节
+					const auto pack = [](std::uint64_t value) {
+						value = (value | (value >> 8)) & 0x0000FFFF0000FFFF;
+						return (value | (value >> 16)) & 0xFFFFFFFF;
+					};
+					chunk = pack(low) | (pack(high) << 32);
+				}
+
+				if (!IsEightDigits(chunk))
+				{
 					break;
-				default:
-					CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid option."));
 				}
+
+				result = result * 100000000 + ParseEightDigits(chunk);
+				consumed += ChunkSize;
 			}
 
-			assert(2 <= base && base <= 36);
+			return consumed;
+		}
+
+		/// @brief  不经解码，直接按编码单元转换数字，用于 ASCII 兼容的编码
+		template <typename CharType>
+		constexpr AsciiToNumberResult AsciiUnitsToNumber(std::span<const CharType> const& units,
+		                                                 std::size_t base) noexcept
+		{
+			std::uintmax_t result{};
+			std::size_t consumed{};
+			auto overflowed = false;
 
-			if constexpr (std::is_signed_v<T>)
+			if constexpr (sizeof(CharType) <= 2 && std::endian::native == std::endian::little)
 			{
-				if (value < 0)
+				if (base == 10 && !std::is_constant_evaluated())
 				{
-					Encoding::CodePage::CodePageTrait<CodePageValue>::FromCodePoint(
-					    '-', [&](auto const& result) {
-						    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
-						                  Encoding::EncodingResultCode::Accept)
-						    {
-							    std::forward<OutputReceiver>(receiver)(result.Result);
-						    }
-					    });
-
-					if (value == std::numeric_limits<T>::min())
-					{
-						isSignedMin = true;
-						value = std::numeric_limits<T>::max();
-					}
-					else
-					{
-						value = -value;
-					}
+					consumed = ParseDecimalSwar(units, result);
 				}
 			}
 
-			// value 此时为非负数
-			std::size_t digitCount{ 1 };
-			auto testValue = value;
-			while (testValue /= base)
+			for (; consumed < units.size(); ++consumed)
 			{
-				++digitCount;
+				const auto digit = GetDigitValue(static_cast<std::uint32_t>(units[consumed]));
+				if (digit >= base)
+				{
+					break;
+				}
+				overflowed = overflowed || AccumulateDigit(result, digit, base);
 			}
 
-			constexpr Encoding::CodePointType DecimalBase{ '0' };
-			constexpr Encoding::CodePointType LowerHexBase{ 'a' };
-			constexpr Encoding::CodePointType UpperHexBase{ 'A' };
+			return { overflowed ? std::numeric_limits<std::uintmax_t>::max() : result, consumed,
+				     overflowed };
+		}
+	} // namespace Detail
+
+	/// @brief  将开头的 ASCII 数字转换为数值，遇到不是数字的码点时停止，并报告是否溢出
+	/// @remark 溢出时仍然消费之后的所有数字
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+	constexpr AsciiToNumberResult AsciiToNumberWithOverflow(
+	    Encoding::StringView<CodePageValue, Extent> const& str, std::size_t base = 10)
+	{
+		assert(2 <= base && base <= 36);
+
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
 
-			for (std::size_t i = digitCount; i > 0; --i)
+		if constexpr (IsAsciiCompatible<CodePageValue>)
+		{
+			return Detail::AsciiUnitsToNumber(std::span<const CharType>(str.GetSpan()), base);
+		}
+		else
+		{
+			std::uintmax_t result{};
+			std::size_t resultAdvanceCount{};
+			auto overflowed = false;
+			for (std::span<const CharType> rest = str.GetSpan(); !rest.empty();)
 			{
-				auto number = value / Core::Misc::Math::Pow(base, i - 1) % base;
-				if (i == 1 && isSignedMin)
+				const auto [codePoint, advanceCount] =
+				    Detail::DecodeFirstCodePoint<CodePageValue>(rest);
+				rest = rest.subspan(advanceCount);
+				const auto digit = Detail::GetDigitValue(codePoint);
+				if (digit >= base)
 				{
-					++number;
+					break;
 				}
-				const Encoding::CodePointType codePoint =
-				    number < 10 ? DecimalBase + number
-				                : (useUppercase ? UpperHexBase : LowerHexBase) + (number - 10);
-				Encoding::CodePage::CodePageTrait<CodePageValue>::FromCodePoint(
-				    codePoint, [&](auto const& result) {
-					    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
-					                  Encoding::EncodingResultCode::Accept)
-					    {
-						    std::forward<OutputReceiver>(receiver)(result.Result);
-					    }
-				    });
+				overflowed = overflowed || Detail::AccumulateDigit(result, digit, base);
+				resultAdvanceCount += advanceCount;
 			}
+
+			return { overflowed ? std::numeric_limits<std::uintmax_t>::max() : result,
+				     resultAdvanceCount, overflowed };
 		}
+	}
 
-		template <typename T, Encoding::CodePage::CodePageType CodePageValue,
-		          typename OutputReceiver>
-		static constexpr void
-		FloatingToString(T value, Encoding::StringView<CodePageValue> const& formatOption,
-		                 OutputReceiver&& receiver)
-		{
-			// 有效小数部分
-			std::size_t significantDecimal{ 5 };
+	/// @brief  将开头的 ASCII 数字转换为数值，遇到不是数字的码点时停止
+	/// @remark 需要得知是否溢出时使用 AsciiToNumberWithOverflow
+	/// @return 结果及消费的编码单元数量，溢出时结果为 std::uintmax_t 的最大值
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+	constexpr std::pair<std::uintmax_t, std::size_t>
+	AsciiToNumber(Encoding::StringView<CodePageValue, Extent> const& str, std::size_t base = 10)
+	{
+		const auto result = AsciiToNumberWithOverflow(str, base);
+		return { result.Value, result.Size };
+	}
+
+	enum class ParseNumberResultCode
+	{
+		Success,
+		Invalid,  ///< 开头不是有效的数字
+		Overflow,  ///< 数字超出目标类型可表示的范围
+		Underflow, ///< 浮点数的绝对值过小，无法以目标类型表示
+	};
+
+	template <typename T>
+	struct ParseNumberResult
+	{
+		ParseNumberResultCode ResultCode;
+		/// @brief  转换结果，溢出时为目标类型的最大值或最小值，下溢时为带符号的零
+		T Result;
+		/// @brief  消费的编码单元数量，无效时为 0
+		std::size_t AdvanceCount;
+	};
 
-			// TODO: 解析格式化选项
-			CodePointIterator<CodePageValue> read{ formatOption.GetSpan() };
-			const CodePointIterator<CodePageValue> end{};
-			for (; read != end; ++read)
+	namespace Detail
+	{
+		/// @brief  将开头的码点作为 ASCII 字符解码，不是 ASCII 字符时返回 0
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		constexpr std::pair<char, std::size_t> DecodeFirstAsciiChar(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType> const&
+		        span) noexcept
+		{
+			if constexpr (IsAsciiCompatible<CodePageValue>)
 			{
-				const auto item = *read;
-				switch (item.first)
-				{
-				default:
-					CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid option."));
-				}
+				const auto unit = static_cast<std::uint32_t>(span[0]);
+				return { unit < 0x80 ? static_cast<char>(unit) : '\0', 1 };
 			}
-
-			if (value != value)
+			else
 			{
-				// 是 NaN
-				constexpr Encoding::CodePointType NanStr[] = { 'N', 'a', 'N' };
-				Encoding::Encoder<Encoding::CodePage::CodePoint, CodePageValue>::EncodeAll(
-				    std::span(NanStr), [&](auto const& result) {
-					    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
-					                  Encoding::EncodingResultCode::Accept)
-					    {
-						    std::forward<OutputReceiver>(receiver)(result.Result);
-					    }
-				    });
-				return;
+				const auto [codePoint, advanceCount] = DecodeFirstCodePoint<CodePageValue>(span);
+				return { codePoint < 0x80 ? static_cast<char>(codePoint) : '\0', advanceCount };
 			}
+		}
+
+		constexpr bool IsFloatingChar(char c) noexcept
+		{
+			return ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+			       c == '.' || c == '+' || c == '-';
+		}
 
-			if (value > std::numeric_limits<std::intmax_t>::max() ||
-			    value < std::numeric_limits<std::intmax_t>::min())
+		/// @brief  以定点表示 T 的任意值的往返所需的最短形式时的长度上界，含符号、前导零及小数点
+		/// @remark 次正规数比 min_exponent10 至多再小 max_digits10 个数量级
+		template <std::floating_point T>
+		constexpr std::size_t MaxFloatingLiteralLength =
+		    static_cast<std::size_t>(std::max(std::numeric_limits<T>::max_exponent10,
+		                                      -std::numeric_limits<T>::min_exponent10)) +
+		    2 * std::numeric_limits<T>::max_digits10 + 3;
+
+		/// @brief  判断 [begin, end) 中的十进制浮点数的绝对值是否小于 1，用于区分下溢与上溢
+		constexpr bool IsFloatingMagnitudeBelowOne(const char* begin, const char* end) noexcept
+		{
+			if (begin != end && *begin == '-')
 			{
-				CAFE_THROW(FormatException, CAFE_UTF8_SV("value is too big, not implemented now."));
+				++begin;
 			}
 
-			// TODO: 偷懒做法，bug 很多
+			// 整数部分的有效数字个数，及小数部分首个非零数字前的零的个数
+			std::intmax_t integerDigitCount{};
+			std::intmax_t fractionZeroCount{};
+			auto inFraction = false;
+			auto fractionNonZeroSeen = false;
+			for (; begin != end && *begin != 'e' && *begin != 'E'; ++begin)
+			{
+				if (*begin == '.')
+				{
+					inFraction = true;
+				}
+				else if (!inFraction)
+				{
+					if (integerDigitCount || *begin != '0')
+					{
+						++integerDigitCount;
+					}
+				}
+				else if (!fractionNonZeroSeen)
+				{
+					if (*begin == '0')
+					{
+						++fractionZeroCount;
+					}
+					else
+					{
+						fractionNonZeroSeen = true;
+					}
+				}
+			}
 
-			// 输出整数部分
-			IntegerToString(static_cast<std::intmax_t>(value),
-			                Encoding::StringView<CodePageValue>{},
-			                std::forward<OutputReceiver>(receiver));
-			if (value < T{})
+			std::intmax_t exponent{};
+			auto isExponentNegative = false;
+			if (begin != end)
 			{
-				value = -value;
+				++begin;
+				if (begin != end && (*begin == '-' || *begin == '+'))
+				{
+					isExponentNegative = *begin == '-';
+					++begin;
+				}
+
+				// 超出范围的指数均等价，饱和以避免溢出
+				constexpr auto ExponentLimit = std::numeric_limits<std::intmax_t>::max() / 20;
+				for (; begin != end && exponent < ExponentLimit; ++begin)
+				{
+					exponent = exponent * 10 + (*begin - '0');
+				}
 			}
 
-			value -= static_cast<std::intmax_t>(value);
+			const auto order = integerDigitCount ? integerDigitCount - 1 : -fractionZeroCount - 1;
+			return order + (isExponentNegative ? -exponent : exponent) < 0;
+		}
 
-			if (value > std::numeric_limits<T>::epsilon())
+		template <std::floating_point T>
+		ParseNumberResult<T> FloatingFromChars(const char* begin, const char* end) noexcept
+		{
+			T value{};
+			const auto [ptr, ec] = std::from_chars(begin, end, value);
+			const auto consumed = static_cast<std::size_t>(ptr - begin);
+			if (ec == std::errc::invalid_argument)
 			{
-				// 输出小数部分
-				Encoding::CodePage::CodePageTrait<CodePageValue>::FromCodePoint(
-				    '.', [&](auto const& result) {
-					    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
-					                  Encoding::EncodingResultCode::Accept)
-					    {
-						    std::forward<OutputReceiver>(receiver)(result.Result);
-					    }
-				    });
-				value *= Core::Misc::Math::Pow(10, significantDecimal);
-				IntegerToString(static_cast<std::intmax_t>(value),
-				                Encoding::StringView<CodePageValue>{},
-				                std::forward<OutputReceiver>(receiver));
+				return { ParseNumberResultCode::Invalid, T{}, 0 };
+			}
+			if (ec == std::errc::result_out_of_range)
+			{
+				// from_chars 不修改 value，按照符号饱和到零或无穷
+				const auto isNegative = *begin == '-';
+				if (IsFloatingMagnitudeBelowOne(begin, ptr))
+				{
+					return { ParseNumberResultCode::Underflow, isNegative ? -T{} : T{}, consumed };
+				}
+				const auto infinity = std::numeric_limits<T>::infinity();
+				return { ParseNumberResultCode::Overflow, isNegative ? -infinity : infinity,
+					     consumed };
 			}
+			return { ParseNumberResultCode::Success, value, consumed };
 		}
-	};
+	} // namespace Detail
 
-	struct StringStreamStringConverter
+	/// @brief  将开头的 ASCII 数字转换为整数，支持前导的负号
+	/// @remark 不跳过空白，也不接受前导的正号，与 std::from_chars 一致
+	template <std::integral T, Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+	requires(!std::same_as<T, bool>) constexpr ParseNumberResult<T> ParseNumber(
+	    Encoding::StringView<CodePageValue, Extent> const& str, std::size_t base = 10)
 	{
-	private:
-		std::stringstream m_InternalBuffer;
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
 
-	public:
-		template <typename T, Encoding::CodePage::CodePageType CodePageValue,
-		          typename OutputReceiver>
-		void ToString(T const& value,
-		              [[maybe_unused]] Encoding::StringView<CodePageValue> const& formatOption,
-		              OutputReceiver&& receiver)
+		std::span<const CharType> rest = str.GetSpan();
+		if (rest.empty())
 		{
-			m_InternalBuffer << value;
-			const auto tmpStr = EncodeFromNarrow<CodePageValue>(m_InternalBuffer.str());
-			std::forward<OutputReceiver>(receiver)(tmpStr.GetView().GetSpan());
-			m_InternalBuffer.str({});
-			m_InternalBuffer.clear();
+			return { ParseNumberResultCode::Invalid, T{}, 0 };
 		}
-	};
 
-	struct StdToStringStringConverter
-	{
-		template <typename T, Encoding::CodePage::CodePageType CodePageValue,
-		          typename OutputReceiver>
-		void ToString(T const& value,
-		              [[maybe_unused]] Encoding::StringView<CodePageValue> const& formatOption,
-		              OutputReceiver&& receiver)
+		std::size_t signCount{};
+		auto isNegative = false;
+		if constexpr (std::is_signed_v<T>)
 		{
-			const auto result = std::to_string(value);
-			const auto tmpStr = EncodeFromNarrow<CodePageValue>(result);
-			std::forward<OutputReceiver>(receiver)(tmpStr.GetView().GetSpan());
+			const auto [c, advanceCount] = Detail::DecodeFirstAsciiChar<CodePageValue>(rest);
+			if (c == '-')
+			{
+				isNegative = true;
+				signCount = advanceCount;
+				rest = rest.subspan(advanceCount);
+			}
 		}
-	};
-
-	template <Encoding::CodePage::CodePageType CodePageValue>
-	struct FormatInfo
-	{
-		std::size_t Index;
-		Encoding::StringView<CodePageValue> FormatOptionText;
-	};
-
-	struct DefaultFormatter
-	{
-		static constexpr Encoding::CodePointType FormatPrefix{ '$' };
-		static constexpr Encoding::CodePointType FormatLeftQuote{ '{' };
-		static constexpr Encoding::CodePointType FormatOptionToken{ ':' };
-		static constexpr Encoding::CodePointType FormatRightQuote{ '}' };
 
-		constexpr DefaultFormatter() noexcept : m_CurrentMode{ Mode::Unknown }, m_CurrentIndex{}
+		const auto [value, digitCount, overflowed] =
+		    AsciiToNumberWithOverflow(Encoding::StringView<CodePageValue>{ rest }, base);
+		if (digitCount == 0)
 		{
+			return { ParseNumberResultCode::Invalid, T{}, 0 };
 		}
 
-	private:
-		enum class Mode
+		using UnsignedType = std::make_unsigned_t<T>;
+		const auto advanceCount = signCount + digitCount;
+		const auto limit = static_cast<std::uintmax_t>(std::numeric_limits<T>::max()) + isNegative;
+		if (overflowed || value > limit)
 		{
-			Unknown,
-			IndexMode,
-			AutoMode,
-		};
+			return { ParseNumberResultCode::Overflow,
+				     isNegative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max(),
+				     advanceCount };
+		}
 
-		Mode m_CurrentMode;
+		const auto magnitude = static_cast<UnsignedType>(value);
+		return { ParseNumberResultCode::Success,
+			     static_cast<T>(isNegative ? static_cast<UnsignedType>(0 - magnitude) : magnitude),
+			     advanceCount };
+	}
 
-		// 不使用索引时自动增加索引并选择参数，不可与使用索引混用
-		std::size_t m_CurrentIndex;
+	/// @brief  将开头的浮点数转换为数值，语法与 std::chars_format::general 的 std::from_chars 一致
+	/// @remark 对 UTF-8 直接解析原字符串，其余编码仅将可能属于浮点数的 ASCII 字符复制到栈上缓冲区，
+	///         不进行完整的转码，也不分配内存
+	///         此时超过 Detail::MaxFloatingLiteralLength<T> 个字符的数字返回 Invalid
+	///         上溢时返回 Overflow，结果为带符号的无穷；下溢时返回 Underflow，结果为带符号的零
+	template <std::floating_point T, Encoding::CodePage::CodePageType CodePageValue,
+	          std::size_t Extent>
+	ParseNumberResult<T> ParseNumber(Encoding::StringView<CodePageValue, Extent> const& str)
+	{
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
 
-		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+		const std::span<const CharType> span = str.GetSpan();
+		if constexpr (sizeof(CharType) == 1 && IsAsciiCompatible<CodePageValue>)
+		{
+			const auto begin = reinterpret_cast<const char*>(span.data());
+			return Detail::FloatingFromChars<T>(begin, begin + span.size());
+		}
+		else
+		{
+			// 足够容纳 T 的任意值的定点表示，不需要堆上的缓冲区
+			constexpr auto BufferSize = Detail::MaxFloatingLiteralLength<T>;
+			std::array<char, BufferSize> buffer;
+			std::size_t charCount{};
+			auto isTruncated = false;
+
+			for (auto rest = span; !rest.empty();)
+			{
+				const auto [c, advanceCount] = Detail::DecodeFirstAsciiChar<CodePageValue>(rest);
+				if (!Detail::IsFloatingChar(c))
+				{
+					break;
+				}
+				if (charCount == BufferSize)
+				{
+					isTruncated = true;
+					break;
+				}
+				buffer[charCount++] = c;
+				rest = rest.subspan(advanceCount);
+			}
+
+			if (!charCount)
+			{
+				return { ParseNumberResultCode::Invalid, T{}, 0 };
+			}
+
+			auto result = Detail::FloatingFromChars<T>(buffer.data(), buffer.data() + charCount);
+
+			// 被截断时，数字之后须仍有判断指数所需的 'e'、符号及一位数字，否则数字过长，作为无效的输入
+			if (isTruncated && result.AdvanceCount + 3 > BufferSize)
+			{
+				return { ParseNumberResultCode::Invalid, T{}, 0 };
+			}
+
+			// 收集的字符均为单个码点，需要换算回编码单元数量
+			if constexpr (!IsAsciiCompatible<CodePageValue>)
+			{
+				std::size_t advanceCount{};
+				for (std::size_t i = 0; i < result.AdvanceCount; ++i)
+				{
+					advanceCount +=
+					    Detail::DecodeFirstCodePoint<CodePageValue>(span.subspan(advanceCount))
+					        .second;
+				}
+				result.AdvanceCount = advanceCount;
+			}
+
+			return result;
+		}
+	}
+
+	/// @brief  格式化结果的输出目标
+	/// @remark Reserve(n) 返回长度为 n 的可写入区域，之后 Commit(m) 提交其中前 m 个编码单元，m 不超过 n，
+	///         两次调用之间不能调用其他成员函数
+	///         Append 直接追加一段编码单元
+	///         可选地提供 AppendAscii(std::span<const char>)，数值等 ASCII 结果将直接交给它而不经过 Reserve
+	template <typename T>
+	concept OutputSink = requires(
+	    T& sink, std::size_t size,
+	    std::span<const typename Encoding::CodePage::CodePageTrait<T::UsingCodePage>::CharType> units)
+	{
+		{
+			sink.Reserve(size)
+			} -> std::same_as<
+			    std::span<typename Encoding::CodePage::CodePageTrait<T::UsingCodePage>::CharType>>;
+		sink.Commit(size);
+		sink.Append(units);
+	};
+
+	namespace Detail
+	{
+		/// @brief  整数结果的最大长度，即符号及二进制表示下的所有位
+		constexpr std::size_t MaxIntegerLength = std::numeric_limits<std::uintmax_t>::digits + 1;
+
+		/// @brief  无法直接写入目标的输出使用的暂存区，较短时不分配内存
+		/// @remark 内部缓冲区可容纳任意整数及以最短表示格式化的浮点数，指定较大精度的浮点数等才分配内存
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		class SinkStagingBuffer
+		{
+		public:
+			using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+			static constexpr std::size_t InlineSize = MaxIntegerLength;
+
+			constexpr std::span<CharType> Get(std::size_t size)
+			{
+				if (size <= m_Buffer.size())
+				{
+					m_Current = m_Buffer.data();
+				}
+				else
+				{
+					m_LargeBuffer.resize(size);
+					m_Current = m_LargeBuffer.data();
+				}
+
+				return { m_Current, size };
+			}
+
+			/// @brief  获得上次 Get 返回的区域中的前 size 个编码单元
+			constexpr std::span<const CharType> Committed(std::size_t size) const noexcept
+			{
+				return { m_Current, size };
+			}
+
+		private:
+			std::array<CharType, InlineSize> m_Buffer{};
+			std::vector<CharType> m_LargeBuffer;
+			CharType* m_Current{};
+		};
+
+		/// @brief  为 OutputSink 提供兼容旧有接收器的调用方式，可接收单个编码单元、span 或 StringView
+		template <typename Derived, Encoding::CodePage::CodePageType CodePageValue>
+		struct OutputSinkCallOperator
+		{
+			using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+			constexpr void operator()(CharType unit)
+			{
+				static_cast<Derived&>(*this).Append(std::span<const CharType>(&unit, 1));
+			}
+
+			constexpr void operator()(std::span<const CharType> units)
+			{
+				static_cast<Derived&>(*this).Append(units);
+			}
+
+			template <std::size_t Extent>
+			constexpr void operator()(Encoding::StringView<CodePageValue, Extent> const& str)
+			{
+				static_cast<Derived&>(*this).Append(str.GetTrimmedSpan());
+			}
+		};
+	} // namespace Detail
+
+	/// @brief  将结果按段交给接收器的 OutputSink，用于兼容以 span 为参数的接收器
+	template <Encoding::CodePage::CodePageType CodePageValue, typename OutputReceiver>
+	class ReceiverSink
+	    : public Detail::OutputSinkCallOperator<ReceiverSink<CodePageValue, OutputReceiver>,
+	                                            CodePageValue>
+	{
+	public:
+		static constexpr Encoding::CodePage::CodePageType UsingCodePage = CodePageValue;
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+		constexpr explicit ReceiverSink(OutputReceiver receiver)
+		    : m_Receiver(std::forward<OutputReceiver>(receiver))
+		{
+		}
+
+		constexpr std::span<CharType> Reserve(std::size_t size)
+		{
+			return m_Buffer.Get(size);
+		}
+
+		constexpr void Commit(std::size_t size)
+		{
+			Append(m_Buffer.Committed(size));
+		}
+
+		constexpr void Append(std::span<const CharType> units)
+		{
+			if (!units.empty())
+			{
+				m_Receiver(units);
+			}
+		}
+
+	private:
+		OutputReceiver m_Receiver;
+		Detail::SinkStagingBuffer<CodePageValue> m_Buffer;
+	};
+
+	/// @brief  追加到 Encoding::String 的 OutputSink
+	/// @remark 字符串可改变长度时，Reserve 直接返回字符串的剩余空间，Commit 时截去未使用的部分，
+	///         否则使用暂存区
+	template <Encoding::CodePage::CodePageType CodePageValue, typename Allocator,
+	          std::size_t SsoThresholdSize, typename GrowPolicy>
+	class StringSink
+	    : public Detail::OutputSinkCallOperator<
+	          StringSink<CodePageValue, Allocator, SsoThresholdSize, GrowPolicy>, CodePageValue>
+	{
+	public:
+		static constexpr Encoding::CodePage::CodePageType UsingCodePage = CodePageValue;
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+		using StringType = Encoding::String<CodePageValue, Allocator, SsoThresholdSize, GrowPolicy>;
+
+		explicit StringSink(StringType& str) noexcept : m_String{ str }
+		{
+		}
+
+		std::span<CharType> Reserve(std::size_t size)
+		{
+			if constexpr (IsResizable)
+			{
+				// GetSize 可能包含结尾的空字符，改变长度时保持其差值
+				m_Buffer.ContentSize = m_String.GetView().GetTrimmedSpan().size();
+				m_Buffer.ExtraSize = m_String.GetSize() - m_Buffer.ContentSize;
+				m_String.Resize(m_Buffer.ContentSize + size + m_Buffer.ExtraSize);
+				return { m_String.GetData() + m_Buffer.ContentSize, size };
+			}
+			else
+			{
+				return m_Buffer.Get(size);
+			}
+		}
+
+		void Commit(std::size_t size)
+		{
+			if constexpr (IsResizable)
+			{
+				m_String.Resize(m_Buffer.ContentSize + size + m_Buffer.ExtraSize);
+			}
+			else
+			{
+				Append(m_Buffer.Committed(size));
+			}
+		}
+
+		void Append(std::span<const CharType> units)
+		{
+			m_String.Append(units);
+		}
+
+	private:
+		static constexpr bool IsResizable = Detail::ResizableString<StringType, CharType>;
+
+		/// @brief  直接写入字符串时记录 Reserve 前的长度
+		struct ReservedSize
+		{
+			std::size_t ContentSize;
+			std::size_t ExtraSize;
+		};
+
+		StringType& m_String;
+		std::conditional_t<IsResizable, ReservedSize, Detail::SinkStagingBuffer<CodePageValue>>
+		    m_Buffer{};
+	};
+
+	/// @brief  仅统计结果长度的 OutputSink
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	class CountingSink
+	    : public Detail::OutputSinkCallOperator<CountingSink<CodePageValue>, CodePageValue>
+	{
+	public:
+		static constexpr Encoding::CodePage::CodePageType UsingCodePage = CodePageValue;
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+		constexpr std::span<CharType> Reserve(std::size_t size)
+		{
+			return m_Buffer.Get(size);
+		}
+
+		constexpr void Commit(std::size_t size) noexcept
+		{
+			m_Size += size;
+		}
+
+		constexpr void Append(std::span<const CharType> units) noexcept
+		{
+			m_Size += units.size();
+		}
+
+		constexpr std::size_t GetSize() const noexcept
+		{
+			return m_Size;
+		}
+
+	private:
+		std::size_t m_Size{};
+		Detail::SinkStagingBuffer<CodePageValue> m_Buffer;
+	};
+
+	namespace Detail
+	{
+		/// @brief  获得 units 中不超过 limit 个编码单元且不截断码点的最长前缀的长度
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		constexpr std::size_t FitCodePoints(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType> const&
+		        units,
+		    std::size_t limit) noexcept
+		{
+			if constexpr (!Encoding::CodePage::CodePageTrait<CodePageValue>::IsVariableWidth)
+			{
+				return std::min(units.size(), limit);
+			}
+			else
+			{
+				std::size_t size{};
+				while (size < units.size())
+				{
+					const auto advanceCount =
+					    DecodeFirstCodePoint<CodePageValue>(units.subspan(size)).second;
+					if (size + advanceCount > limit)
+					{
+						break;
+					}
+					size += advanceCount;
+				}
+				return size;
+			}
+		}
+	} // namespace Detail
+
+	/// @brief  写入定长缓冲区的 OutputSink
+	/// @remark 空间不足时在码点边界处截断，之后的结果不再写入而仅计入所需的长度
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	class SpanSink : public Detail::OutputSinkCallOperator<SpanSink<CodePageValue>, CodePageValue>
+	{
+	public:
+		static constexpr Encoding::CodePage::CodePageType UsingCodePage = CodePageValue;
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+		constexpr explicit SpanSink(std::span<CharType> buffer) noexcept : m_Buffer{ buffer }
+		{
+		}
+
+		constexpr std::span<CharType> Reserve(std::size_t size)
+		{
+			m_ReservedInBuffer = !m_Truncated && size <= m_Buffer.size() - m_WrittenSize;
+			return m_ReservedInBuffer ? m_Buffer.subspan(m_WrittenSize, size) : m_Staging.Get(size);
+		}
+
+		constexpr void Commit(std::size_t size)
+		{
+			if (m_ReservedInBuffer)
+			{
+				m_WrittenSize += size;
+				m_RequiredSize += size;
+			}
+			else
+			{
+				Append(m_Staging.Committed(size));
+			}
+		}
+
+		constexpr void Append(std::span<const CharType> units)
+		{
+			m_RequiredSize += units.size();
+			if (m_Truncated)
+			{
+				return;
+			}
+
+			auto size = units.size();
+			const auto rest = m_Buffer.size() - m_WrittenSize;
+			if (size > rest)
+			{
+				size = Detail::FitCodePoints<CodePageValue>(units, rest);
+				m_Truncated = true;
+			}
+
+			std::copy_n(units.begin(), size, m_Buffer.begin() + m_WrittenSize);
+			m_WrittenSize += size;
+		}
+
+		/// @brief  已写入的编码单元数量
+		constexpr std::size_t GetWrittenSize() const noexcept
+		{
+			return m_WrittenSize;
+		}
+
+		/// @brief  完整写入结果所需的编码单元数量
+		constexpr std::size_t GetRequiredSize() const noexcept
+		{
+			return m_RequiredSize;
+		}
+
+	private:
+		std::span<CharType> m_Buffer;
+		std::size_t m_WrittenSize{};
+		std::size_t m_RequiredSize{};
+		bool m_Truncated{};
+		bool m_ReservedInBuffer{};
+		Detail::SinkStagingBuffer<CodePageValue> m_Staging;
+	};
+
+	namespace Detail
+	{
+		/// @brief  以 OutputSink 的形式调用 func，output 不是 OutputSink 时使用 ReceiverSink 包装
+		template <Encoding::CodePage::CodePageType CodePageValue, typename Output, typename Func>
+		constexpr void WithOutputSink(Output&& output, Func&& func)
+		{
+			using OutputType = Core::Misc::RemoveCvRef<Output>;
+			if constexpr (OutputSink<OutputType>)
+			{
+				static_assert(OutputType::UsingCodePage == CodePageValue,
+				              "Code page of the sink does not match the format string.");
+				std::forward<Func>(func)(output);
+			}
+			else
+			{
+				ReceiverSink<CodePageValue, Output&> sink{ output };
+				std::forward<Func>(func)(sink);
+			}
+		}
+	} // namespace Detail
+
+	/// @brief  格式化结果长度的提示，单位为编码单元
+	struct FormatSizeHint
+	{
+		std::size_t Size;
+		// 为 true 时 Size 为准确的长度，否则为估计值
+		bool IsExact;
+
+		constexpr FormatSizeHint& operator+=(FormatSizeHint const& other) noexcept
+		{
+			Size += other.Size;
+			IsExact = IsExact && other.IsExact;
+			return *this;
+		}
+	};
+
+	namespace Detail
+	{
+		/// @brief  分离整数的符号与绝对值，对有符号数的最小值也适用
+		/// @return 是否为负数及绝对值
+		template <typename T>
+		constexpr std::pair<bool, std::uintmax_t> SplitSign(T value) noexcept
+		{
+			if constexpr (std::is_signed_v<T>)
+			{
+				if (value < 0)
+				{
+					return { true, std::uintmax_t{} - static_cast<std::uintmax_t>(value) };
+				}
+			}
+
+			return { false, static_cast<std::uintmax_t>(value) };
+		}
+
+		constexpr auto PowersOf10 = [] {
+			std::array<std::uintmax_t, std::numeric_limits<std::uintmax_t>::digits10 + 1> result{};
+			std::uintmax_t value{ 1 };
+			for (auto& item : result)
+			{
+				item = value;
+				value *= 10;
+			}
+			return result;
+		}();
+
+		/// @brief  计算 value 以 base 进制表示时的位数
+		/// @remark 2 的幂进制可由二进制位数直接得到，十进制由二进制位数估计后再以 10 的幂修正
+		constexpr std::size_t CountDigits(std::uintmax_t value, std::size_t base) noexcept
+		{
+			if (!value)
+			{
+				return 1;
+			}
+
+			if (std::has_single_bit(base))
+			{
+				const auto shift = static_cast<std::size_t>(std::countr_zero(base));
+				return (std::bit_width(value) + shift - 1) / shift;
+			}
+
+			if (base == 10)
+			{
+				// 1233 / 4096 约为 log10(2)
+				const auto estimate = static_cast<std::size_t>(std::bit_width(value)) * 1233 >> 12;
+				return estimate + 1 -
+				       (estimate < PowersOf10.size() && value < PowersOf10[estimate]);
+			}
+
+			std::size_t digitCount{ 1 };
+			while (value /= base)
+			{
+				++digitCount;
+			}
+			return digitCount;
+		}
+
+		constexpr char LowerDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+		constexpr char UpperDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+		// 00 至 99 的两位十进制数字表，每次查表可以产生两位
+		constexpr auto DecimalDigitPairs = [] {
+			std::array<char, 200> result{};
+			for (std::size_t i = 0; i < 100; ++i)
+			{
+				result[i * 2] = static_cast<char>('0' + i / 10);
+				result[i * 2 + 1] = static_cast<char>('0' + i % 10);
+			}
+			return result;
+		}();
+
+		/// @brief  从 end 开始向前写入整数的 ASCII 表示
+		/// @return 写入的开头
+		template <typename OutputCharType>
+		constexpr OutputCharType* WriteIntegerBackward(OutputCharType* end, bool isNegative,
+		                                               std::uintmax_t magnitude, std::size_t base,
+		                                               bool useUppercase) noexcept
+		{
+			auto current = end;
+			const auto digits = useUppercase ? UpperDigits : LowerDigits;
+			switch (base)
+			{
+			case 10:
+				while (magnitude >= 100)
+				{
+					const auto index = static_cast<std::size_t>(magnitude % 100) * 2;
+					magnitude /= 100;
+					*--current = static_cast<OutputCharType>(DecimalDigitPairs[index + 1]);
+					*--current = static_cast<OutputCharType>(DecimalDigitPairs[index]);
+				}
+				if (magnitude >= 10)
+				{
+					const auto index = static_cast<std::size_t>(magnitude) * 2;
+					*--current = static_cast<OutputCharType>(DecimalDigitPairs[index + 1]);
+					*--current = static_cast<OutputCharType>(DecimalDigitPairs[index]);
+				}
+				else
+				{
+					*--current = static_cast<OutputCharType>('0' + magnitude);
+				}
+				break;
+			case 2:
+			case 8:
+			case 16:
+			{
+				const auto shift = std::countr_zero(base);
+				const auto mask = base - 1;
+				do
+				{
+					*--current = static_cast<OutputCharType>(digits[magnitude & mask]);
+					magnitude >>= shift;
+				} while (magnitude);
+				break;
+			}
+			default:
+				do
+				{
+					*--current = static_cast<OutputCharType>(digits[magnitude % base]);
+					magnitude /= base;
+				} while (magnitude);
+				break;
+			}
+
+			if (isNegative)
+			{
+				*--current = static_cast<OutputCharType>('-');
+			}
+
+			return current;
+		}
+
+		/// @brief  提供 AppendAscii 的 OutputSink，ASCII 结果应直接交给 AppendAscii 而不经过 Reserve
+		template <typename Sink>
+		concept AsciiAppendableSink = requires(Sink& sink, std::span<const char> chars)
+		{
+			sink.AppendAscii(chars);
+		};
+
+		/// @brief  将 ASCII 字符转换到 CodePageValue 编码后写入 sink
+		template <Encoding::CodePage::CodePageType CodePageValue, OutputSink Sink>
+		constexpr void EmitAscii(std::span<const char> chars, Sink& sink)
+		{
+			if constexpr (AsciiAppendableSink<Sink>)
+			{
+				sink.AppendAscii(chars);
+				return;
+			}
+
+			using Trait = Encoding::CodePage::CodePageTrait<CodePageValue>;
+
+			const auto buffer =
+			    sink.Reserve(chars.size() * Encoding::CodePage::GetMaxWidth<CodePageValue>());
+			std::size_t size{};
+			if constexpr (IsAsciiCompatible<CodePageValue>)
+			{
+				for (const auto item : chars)
+				{
+					buffer[size++] = static_cast<typename Trait::CharType>(item);
+				}
+			}
+			else
+			{
+				for (const auto item : chars)
+				{
+					Trait::FromCodePoint(static_cast<Encoding::CodePointType>(item),
+					                     [&](auto const& result) {
+						                     if constexpr (Encoding::GetEncodingResultCode<
+						                                       decltype(result)> ==
+						                                   Encoding::EncodingResultCode::Accept)
+						                     {
+							                     if constexpr (Trait::IsVariableWidth)
+							                     {
+								                     for (const auto unit : result.Result)
+								                     {
+									                     buffer[size++] = unit;
+								                     }
+							                     }
+							                     else
+							                     {
+								                     buffer[size++] = result.Result;
+							                     }
+						                     }
+					                     });
+				}
+			}
+
+			sink.Commit(size);
+		}
+
+		/// @brief  由 ASCII 字符构成的结果的长度提示
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		constexpr FormatSizeHint AsciiSizeHint(std::size_t charCount, bool isExact) noexcept
+		{
+			if constexpr (IsAsciiCompatible<CodePageValue>)
+			{
+				return { charCount, isExact };
+			}
+			else
+			{
+				return { charCount * Encoding::CodePage::GetMaxWidth<CodePageValue>(), false };
+			}
+		}
+	} // namespace Detail
+
+	/// @brief  整数格式化选项
+	/// @remark 可用选项为 b、o、d（或 i）、x、X，分别表示二、八、十、十六进制及大写的十六进制，至多指定一个
+	struct IntegerFormatOption
+	{
+		std::size_t Base;
+		bool UseUppercase;
+
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr IntegerFormatOption
+		Parse(Encoding::StringView<CodePageValue> const& formatOption)
+		{
+			IntegerFormatOption result;
+			TryParse<ThrowOnFormatErrorPolicy>(formatOption, result);
+			return result;
+		}
+
+		/// @brief  分析 formatOption 并写入 result，出错时按 ErrorPolicy 处理
+		template <typename ErrorPolicy, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatErrorCode
+		TryParse(Encoding::StringView<CodePageValue> const& formatOption,
+		         IntegerFormatOption& result) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			result = { 10, false };
+			auto baseSpecified = false;
+
+			for (auto rest = formatOption.GetSpan(); !rest.empty();)
+			{
+				const auto [codePoint, advanceCount] =
+				    Detail::DecodeFirstCodePoint<CodePageValue>(rest);
+				rest = rest.subspan(advanceCount);
+				switch (codePoint)
+				{
+				case 'b':
+					result.Base = 2;
+					break;
+				case 'o':
+					result.Base = 8;
+					break;
+				case 'd':
+				case 'i':
+					result.Base = 10;
+					break;
+				case 'x':
+					result.Base = 16;
+					break;
+				case 'X':
+					result.Base = 16;
+					result.UseUppercase = true;
+					break;
+				default:
+					if constexpr (ErrorPolicy::CheckFormat)
+					{
+						return ErrorPolicy::OnFormatError(FormatErrorCode::InvalidOption);
+					}
+					break;
+				}
+
+				if constexpr (ErrorPolicy::CheckFormat)
+				{
+					if (baseSpecified)
+					{
+						return ErrorPolicy::OnFormatError(FormatErrorCode::BaseRespecified);
+					}
+					baseSpecified = true;
+				}
+			}
+
+			return FormatErrorCode::Success;
+		}
+	};
+
+	/// @brief  浮点数格式化选项
+	/// @remark 可用选项为 f、e、g，分别表示定点、科学计数法及两者中较短者，其后可跟随 .N 以指定精度，
+	///         未指定精度时输出可往返的最短表示，未指定任何选项时在定点与科学计数法中选择较短者
+	struct FloatingFormatOption
+	{
+		/// @brief  可指定的最大精度
+		static constexpr std::size_t MaxPrecision = 128;
+
+		enum class FormatStyle
+		{
+			Shortest,
+			Fixed,
+			Scientific,
+			General,
+		};
+
+		FormatStyle Style;
+		std::optional<std::size_t> Precision;
+
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FloatingFormatOption
+		Parse(Encoding::StringView<CodePageValue> const& formatOption)
+		{
+			FloatingFormatOption result;
+			TryParse<ThrowOnFormatErrorPolicy>(formatOption, result);
+			return result;
+		}
+
+		/// @brief  分析 formatOption 并写入 result，出错时按 ErrorPolicy 处理
+		/// @remark 不检查时过大的精度将被限制为 MaxPrecision
+		template <typename ErrorPolicy, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatErrorCode
+		TryParse(Encoding::StringView<CodePageValue> const& formatOption,
+		         FloatingFormatOption& result) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			result = { FormatStyle::Shortest, {} };
+
+			auto rest = formatOption.GetSpan();
+			if (rest.empty())
+			{
+				return FormatErrorCode::Success;
+			}
+
+			const auto [styleCodePoint, styleAdvanceCount] =
+			    Detail::DecodeFirstCodePoint<CodePageValue>(rest);
+			switch (styleCodePoint)
+			{
+			case 'f':
+				result.Style = FormatStyle::Fixed;
+				break;
+			case 'e':
+				result.Style = FormatStyle::Scientific;
+				break;
+			case 'g':
+				result.Style = FormatStyle::General;
+				break;
+			default:
+				if constexpr (ErrorPolicy::CheckFormat)
+				{
+					return ErrorPolicy::OnFormatError(FormatErrorCode::InvalidOption);
+				}
+				break;
+			}
+
+			rest = rest.subspan(styleAdvanceCount);
+			if (rest.empty())
+			{
+				return FormatErrorCode::Success;
+			}
+
+			if constexpr (ErrorPolicy::CheckFormat)
+			{
+				const auto [pointCodePoint, pointAdvanceCount] =
+				    Detail::DecodeFirstCodePoint<CodePageValue>(rest);
+				if (pointCodePoint != '.')
+				{
+					return ErrorPolicy::OnFormatError(FormatErrorCode::InvalidOption);
+				}
+				rest = rest.subspan(pointAdvanceCount);
+			}
+			else
+			{
+				// '.' 总是占用 1 个编码单元
+				rest = rest.subspan(1);
+			}
+
+			const auto [precision, precisionAdvanceCount, precisionOverflowed] =
+			    AsciiToNumberWithOverflow(Encoding::StringView<CodePageValue>{ rest });
+			if constexpr (ErrorPolicy::CheckFormat)
+			{
+				if (!precisionAdvanceCount || precisionAdvanceCount != rest.size())
+				{
+					return ErrorPolicy::OnFormatError(FormatErrorCode::InvalidOption);
+				}
+
+				if (precisionOverflowed || precision > MaxPrecision)
+				{
+					return ErrorPolicy::OnFormatError(FormatErrorCode::PrecisionTooLarge);
+				}
+			}
+			else if (precisionOverflowed || precision > MaxPrecision)
+			{
+				result.Precision = MaxPrecision;
+				return FormatErrorCode::Success;
+			}
+
+			result.Precision = static_cast<std::size_t>(precision);
+			return FormatErrorCode::Success;
+		}
+	};
+
+	/// @brief  范围格式化选项
+	/// @remark 形如 "元素选项;sep=分隔符"，元素选项应用于每个元素，分隔符为 "sep=" 之后直至选项结尾的全部文本，
+	///         可为空，未指定时使用 ", "，元素选项中不能包含 ';'
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	struct RangeFormatOption
+	{
+		Encoding::StringView<CodePageValue> ElementOption;
+		std::optional<Encoding::StringView<CodePageValue>> Separator;
+
+		/// @brief  分析 formatOption 并写入 result，出错时按 ErrorPolicy 处理
+		template <typename ErrorPolicy>
+		static constexpr FormatErrorCode
+		TryParse(Encoding::StringView<CodePageValue> const& formatOption,
+		         RangeFormatOption& result) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			result = { formatOption, {} };
+
+			const auto span = formatOption.GetSpan();
+			for (std::size_t i = 0; i < span.size();)
+			{
+				const auto [codePoint, advanceCount] =
+				    Detail::DecodeFirstCodePoint<CodePageValue>(span.subspan(i));
+				if (codePoint != ';')
+				{
+					i += advanceCount;
+					continue;
+				}
+
+				result.ElementOption = formatOption.SubStr(0, i);
+				auto rest = span.subspan(i + advanceCount);
+				for (const auto expected : { 's', 'e', 'p', '=' })
+				{
+					const auto [keyCodePoint, keyAdvanceCount] =
+					    rest.empty() ? std::pair{ Encoding::CodePointType{}, std::size_t{} }
+					                 : Detail::DecodeFirstCodePoint<CodePageValue>(rest);
+					if (keyCodePoint != static_cast<Encoding::CodePointType>(expected))
+					{
+						return ErrorPolicy::OnFormatError(FormatErrorCode::InvalidOption);
+					}
+					rest = rest.subspan(keyAdvanceCount);
+				}
+
+				result.Separator = Encoding::StringView<CodePageValue>{ rest };
+				break;
+			}
+
+			return FormatErrorCode::Success;
+		}
+	};
+
+	/// @brief  预先分析的格式化选项，用于预先分析的格式串，使格式化时不必再次分析选项
+	/// @remark 分析格式串时并不知道参数的类型，因此分别按整数及浮点数选项分析，格式化时按参数的类型取用
+	///         无法按某种选项分析时对应的成员为空，此时仍在格式化时分析 Text，以便按转换器的 ErrorPolicy 处理错误
+	///         范围及用户类型的选项仍在格式化时分析
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	struct PreparedFormatOption
+	{
+		Encoding::StringView<CodePageValue> Text;
+		std::optional<IntegerFormatOption> Integer;
+		std::optional<FloatingFormatOption> Floating;
+
+		static constexpr PreparedFormatOption
+		Prepare(Encoding::StringView<CodePageValue> const& formatOption) noexcept
+		{
+			PreparedFormatOption result{ formatOption, {}, {} };
+
+			IntegerFormatOption integerOption{};
+			if (IntegerFormatOption::TryParse<ReturnFormatErrorPolicy>(formatOption,
+			                                                          integerOption) ==
+			    FormatErrorCode::Success)
+			{
+				result.Integer = integerOption;
+			}
+
+			FloatingFormatOption floatingOption{};
+			if (FloatingFormatOption::TryParse<ReturnFormatErrorPolicy>(formatOption,
+			                                                           floatingOption) ==
+			    FormatErrorCode::Success)
+			{
+				result.Floating = floatingOption;
+			}
+
+			return result;
+		}
+	};
+
+	namespace Detail
+	{
+		template <typename T>
+		constexpr bool IsPreparedFormatOption = false;
+
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		constexpr bool IsPreparedFormatOption<PreparedFormatOption<CodePageValue>> = true;
+	} // namespace Detail
+
+	namespace Detail
+	{
+		/// @brief  浮点数结果的最大长度
+		/// @remark 定点表示时为符号、小数点、最大的整数部分及最大精度的小数部分，
+		///         或绝对值小于 1 时最小的次正规数的最短表示，科学计数法的结果总是短于此长度
+		template <typename T>
+		constexpr std::size_t MaxFloatingLength =
+		    2 + std::max<std::size_t>(std::numeric_limits<T>::max_exponent10 + 1 +
+		                                  FloatingFormatOption::MaxPrecision,
+		                              1 - std::numeric_limits<T>::min_exponent10 +
+		                                  std::numeric_limits<T>::max_digits10);
+
+		/// @brief  科学计数法中有效数字以外的部分的最大长度，即符号、小数点、e、指数符号及指数
+		template <typename T>
+		constexpr std::size_t ScientificExtraLength =
+		    4 + CountDigits(std::numeric_limits<T>::max_exponent10, 10);
+
+		/// @brief  以最短表示格式化浮点数的结果长度的上界，使用 max_digits10 位有效数字时必定可以往返
+		template <typename T>
+		constexpr std::size_t ShortestFloatingLength =
+		    std::numeric_limits<T>::max_digits10 + ScientificExtraLength<T>;
+
+		// 通用格式使用定点表示时至多再有 4 个前导零
+		static_assert(ShortestFloatingLength<long double> + 4 <=
+		                  SinkStagingBuffer<Encoding::CodePage::Utf8>::InlineSize,
+		              "Staging buffer should hold the shortest representation of floating points.");
+
+		/// @brief  估计有限的浮点数结果长度的上界
+		template <typename T>
+		std::size_t GetFloatingLengthBound(T value, FloatingFormatOption const& option) noexcept
+		{
+			switch (option.Style)
+			{
+			case FloatingFormatOption::FormatStyle::Fixed:
+			{
+				// value 的绝对值小于 2^exponent，1233 / 4096 略小于 log10(2)，因此多留 1 位
+				int exponent{};
+				std::frexp(value, &exponent);
+				const auto integerDigits =
+				    exponent > 0 ? static_cast<std::size_t>(exponent) * 1233 / 4096 + 2 : 1;
+				const auto fractionDigits = option.Precision.value_or(
+				    exponent > 0
+				        ? std::numeric_limits<T>::max_digits10
+				        : static_cast<std::size_t>(-exponent) * 1233 / 4096 + 2 +
+				              std::numeric_limits<T>::max_digits10);
+				return 2 + integerDigits + fractionDigits;
+			}
+			case FloatingFormatOption::FormatStyle::Scientific:
+				return option.Precision ? 1 + *option.Precision + ScientificExtraLength<T>
+				                        : ShortestFloatingLength<T>;
+			case FloatingFormatOption::FormatStyle::General:
+				// 使用定点表示时至多有 4 个前导零
+				return option.Precision
+				           ? std::max(*option.Precision, std::size_t{ 1 }) + 4 +
+				                 ScientificExtraLength<T>
+				           : ShortestFloatingLength<T> + 4;
+			default:
+				return ShortestFloatingLength<T>;
+			}
+		}
+
+		/// @brief  以 std::to_chars 按选项写入浮点数，value 必须为有限值
+		/// @return 写入的结尾，空间不足时返回 nullptr
+		template <typename T>
+		char* WriteFloating(char* begin, char* end, T value,
+		                    FloatingFormatOption const& option) noexcept
+		{
+			const auto result = [&] {
+				switch (option.Style)
+				{
+				case FloatingFormatOption::FormatStyle::Fixed:
+				case FloatingFormatOption::FormatStyle::Scientific:
+				case FloatingFormatOption::FormatStyle::General:
+				{
+					const auto format =
+					    option.Style == FloatingFormatOption::FormatStyle::Fixed
+					        ? std::chars_format::fixed
+					        : option.Style == FloatingFormatOption::FormatStyle::Scientific
+					              ? std::chars_format::scientific
+					              : std::chars_format::general;
+					return option.Precision ? std::to_chars(begin, end, value, format,
+					                                        static_cast<int>(*option.Precision))
+					                        : std::to_chars(begin, end, value, format);
+				}
+				default:
+					return std::to_chars(begin, end, value);
+				}
+			}();
+
+			return result.ec == std::errc{} ? result.ptr : nullptr;
+		}
+	} // namespace Detail
+
+	namespace Detail
+	{
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		concept HasFormatValue = requires(T const& value,
+		                                  Encoding::StringView<CodePageValue> const& formatOption,
+		                                  CountingSink<CodePageValue>& sink)
+		{
+			FormatValue(value, formatOption, sink);
+		};
+
+		template <typename T>
+		concept CharacterType =
+		    std::is_same_v<T, char> || std::is_same_v<T, wchar_t> || std::is_same_v<T, char8_t> ||
+		    std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+		template <typename T>
+		using RangeElementType = Core::Misc::RemoveCvRef<std::ranges::range_reference_t<T const>>;
+
+		/// @brief  不作为范围格式化的类型
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		constexpr bool IsFormattableAsValue =
+		    std::is_integral_v<T> || std::is_floating_point_v<T> || Encoding::IsStringView<T> ||
+		    Encoding::IsStaticString<T> || Encoding::IsString<T> ||
+		    HasFormatValue<T, CodePageValue>;
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		consteval bool IsFormattable()
+		{
+			if constexpr (IsFormattableAsValue<T, CodePageValue>)
+			{
+				return true;
+			}
+			else if constexpr (std::ranges::input_range<T const>)
+			{
+				// 字符的范围通常表示文本，逐个作为整数格式化并无意义
+				if constexpr (CharacterType<RangeElementType<T>>)
+				{
+					return false;
+				}
+				else
+				{
+					return IsFormattable<RangeElementType<T>, CodePageValue>();
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		/// @brief  作为范围格式化的类型
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		concept FormattableRange = !IsFormattableAsValue<T, CodePageValue> &&
+		                           std::ranges::input_range<T const> &&
+		                           IsFormattable<T, CodePageValue>();
+	} // namespace Detail
+
+	/// @brief  可由 DefaultStringConverter 格式化的类型
+	/// @remark 除内建支持的整数、浮点数及字符串外，用户类型可在其所在命名空间中提供
+	///         template <OutputSink Sink> void FormatValue(T const& value,
+	///             Encoding::StringView<CodePageValue> const& formatOption, Sink& sink)，
+	///         通过 ADL 查找，直接写入 sink，格式化选项无效时应抛出 FormatException，
+	///         或返回 FormatErrorCode 以便在不抛出异常的 ErrorPolicy 下使用
+	///         元素可格式化的范围（元素为字符类型时除外）同样可以格式化，参见 RangeFormatOption
+	template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+	concept Formattable = Detail::IsFormattable<T, CodePageValue>();
+
+	/// @brief  默认的转换器，ErrorPolicy 决定格式化选项无效时的处理方式
+	/// @remark ErrorPolicy 不抛出异常时，ToString 等成员为 noexcept 并返回错误码，
+	///         此时 sink 的操作及 FormatValue 抛出的异常将导致 std::terminate
+	///         FormatValue 可返回 FormatErrorCode 以报告错误
+	template <typename ErrorPolicy = ThrowOnFormatErrorPolicy>
+	struct BasicDefaultStringConverter
+	{
+		using FormatErrorPolicy = ErrorPolicy;
+
+		/// @brief  将 value 格式化后写入 output
+		/// @param  output  OutputSink，或以 span 为参数的接收器
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		static constexpr FormatErrorCode
+		ToString(T const& value, Encoding::StringView<CodePageValue> const& formatOption,
+		         Output&& output) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			auto result = FormatErrorCode::Success;
+			Detail::WithOutputSink<CodePageValue>(output, [&](auto& sink) {
+				if constexpr (std::is_integral_v<T>)
+				{
+					result = IntegerToString(value, formatOption, sink);
+				}
+				else if constexpr (std::is_floating_point_v<T>)
+				{
+					result = FloatingToString(value, formatOption, sink);
+				}
+				else if constexpr (Encoding::IsStringView<T>)
+				{
+					sink.Append(value.GetTrimmedSpan());
+				}
+				else if constexpr (Encoding::IsStaticString<T>)
+				{
+					sink.Append(value.GetSpan());
+				}
+				else if constexpr (Encoding::IsString<T>)
+				{
+					sink.Append(value.GetView().GetTrimmedSpan());
+				}
+				else if constexpr (Detail::FormattableRange<T, CodePageValue>)
+				{
+					result = RangeToString(value, formatOption, sink);
+				}
+				else
+				{
+					static_assert(Formattable<T, CodePageValue>, "Unformattable data.");
+					if constexpr (std::is_same_v<decltype(FormatValue(value, formatOption, sink)),
+					                             FormatErrorCode>)
+					{
+						result = FormatValue(value, formatOption, sink);
+					}
+					else
+					{
+						FormatValue(value, formatOption, sink);
+					}
+				}
+			});
+			return result;
+		}
+
+		/// @brief  以预先分析的格式化选项格式化 value，选项已按 T 对应的方式分析时不再分析其文本
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		static constexpr FormatErrorCode
+		ToString(T const& value, PreparedFormatOption<CodePageValue> const& formatOption,
+		         Output&& output) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			auto result = FormatErrorCode::Success;
+			if constexpr (std::is_integral_v<T>)
+			{
+				if (formatOption.Integer)
+				{
+					Detail::WithOutputSink<CodePageValue>(output, [&](auto& sink) {
+						result = IntegerToString(value, *formatOption.Integer, sink);
+					});
+					return result;
+				}
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				if (formatOption.Floating)
+				{
+					Detail::WithOutputSink<CodePageValue>(output, [&](auto& sink) {
+						result = FloatingToString(value, *formatOption.Floating, sink);
+					});
+					return result;
+				}
+			}
+
+			return ToString(value, formatOption.Text, output);
+		}
+
+		/// @brief  不进行格式化而得到 value 格式化结果的长度提示
+		/// @remark 格式化选项无效时按 ErrorPolicy 处理，不抛出异常时返回 { 0, false }
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatSizeHint
+		GetSizeHint(T const& value,
+		            Encoding::StringView<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				IntegerFormatOption option;
+				if (IntegerFormatOption::TryParse<ErrorPolicy>(formatOption, option) !=
+				    FormatErrorCode::Success)
+				{
+					return { 0, false };
+				}
+
+				return IntegerSizeHint<CodePageValue>(value, option);
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				FloatingFormatOption option;
+				if (FloatingFormatOption::TryParse<ErrorPolicy>(formatOption, option) !=
+				    FormatErrorCode::Success)
+				{
+					return { 0, false };
+				}
+
+				return FloatingSizeHint<CodePageValue>(value, option);
+			}
+			else if constexpr (Encoding::IsStringView<T>)
+			{
+				return { value.GetTrimmedSpan().size(), true };
+			}
+			else if constexpr (Encoding::IsStaticString<T>)
+			{
+				return { value.GetSpan().size(), true };
+			}
+			else if constexpr (Encoding::IsString<T>)
+			{
+				return { value.GetView().GetTrimmedSpan().size(), true };
+			}
+			else
+			{
+				// 不为估计长度而遍历范围
+				return { 0, false };
+			}
+		}
+
+		/// @brief  以预先分析的格式化选项得到长度提示，选项已按 T 对应的方式分析时不再分析其文本
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatSizeHint
+		GetSizeHint(T const& value,
+		            PreparedFormatOption<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				if (formatOption.Integer)
+				{
+					return IntegerSizeHint<CodePageValue>(value, *formatOption.Integer);
+				}
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				if (formatOption.Floating)
+				{
+					return FloatingSizeHint<CodePageValue>(value, *formatOption.Floating);
+				}
+			}
+
+			return GetSizeHint(value, formatOption.Text);
+		}
+
+		/// @brief  检查格式化选项是否适用于类型 T，不适用时按 ErrorPolicy 处理
+		/// @remark 可在编译期求值，用于编译期格式串的检查
+		///         用户类型的格式化选项由 FormatValue 在格式化时检查
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatErrorCode
+		CheckFormatOption(Encoding::StringView<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				IntegerFormatOption option;
+				return IntegerFormatOption::TryParse<ErrorPolicy>(formatOption, option);
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				FloatingFormatOption option;
+				return FloatingFormatOption::TryParse<ErrorPolicy>(formatOption, option);
+			}
+			else if constexpr (Detail::FormattableRange<T, CodePageValue>)
+			{
+				RangeFormatOption<CodePageValue> option;
+				if (const auto result =
+				        RangeFormatOption<CodePageValue>::template TryParse<ErrorPolicy>(
+				            formatOption, option);
+				    result != FormatErrorCode::Success)
+				{
+					return result;
+				}
+				return CheckFormatOption<Detail::RangeElementType<T>>(option.ElementOption);
+			}
+			else
+			{
+				static_assert(Formattable<T, CodePageValue>, "Unformattable data.");
+				return FormatErrorCode::Success;
+			}
+		}
+
+		/// @brief  以预先分析的格式化选项检查，选项已按 T 对应的方式分析成功时不再分析其文本
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatErrorCode
+		CheckFormatOption(PreparedFormatOption<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				if (formatOption.Integer)
+				{
+					return FormatErrorCode::Success;
+				}
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				if (formatOption.Floating)
+				{
+					return FormatErrorCode::Success;
+				}
+			}
+
+			return CheckFormatOption<T>(formatOption.Text);
+		}
+
+	private:
+		/// @brief  依次格式化各元素，元素直接写入 sink
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, OutputSink Sink>
+		static constexpr FormatErrorCode
+		RangeToString(T const& value, Encoding::StringView<CodePageValue> const& formatOption,
+		              Sink& sink)
+		{
+			RangeFormatOption<CodePageValue> option;
+			if (const auto result =
+			        RangeFormatOption<CodePageValue>::template TryParse<ErrorPolicy>(formatOption,
+			                                                                        option);
+			    result != FormatErrorCode::Success)
+			{
+				return result;
+			}
+
+			auto isFirst = true;
+			for (auto&& element : value)
+			{
+				if (!isFirst)
+				{
+					if (option.Separator)
+					{
+						sink.Append(option.Separator->GetTrimmedSpan());
+					}
+					else
+					{
+						constexpr char DefaultSeparator[] = { ',', ' ' };
+						Detail::EmitAscii<CodePageValue>(DefaultSeparator, sink);
+					}
+				}
+				isFirst = false;
+
+				if (const auto result = ToString(element, option.ElementOption, sink);
+				    result != FormatErrorCode::Success)
+				{
+					return result;
+				}
+			}
+
+			return FormatErrorCode::Success;
+		}
+
+		template <Encoding::CodePage::CodePageType CodePageValue, typename T>
+		static constexpr FormatSizeHint
+		IntegerSizeHint(T value, IntegerFormatOption const& option) noexcept
+		{
+			const auto [isNegative, magnitude] = Detail::SplitSign(value);
+			return Detail::AsciiSizeHint<CodePageValue>(
+			    isNegative + Detail::CountDigits(magnitude, option.Base), true);
+		}
+
+		template <Encoding::CodePage::CodePageType CodePageValue, typename T>
+		static constexpr FormatSizeHint
+		FloatingSizeHint(T value, FloatingFormatOption const& option) noexcept
+		{
+			if (value != value)
+			{
+				return Detail::AsciiSizeHint<CodePageValue>(3, true);
+			}
+
+			if (value == std::numeric_limits<T>::infinity() ||
+			    value == -std::numeric_limits<T>::infinity())
+			{
+				return Detail::AsciiSizeHint<CodePageValue>(value > 0 ? 8 : 9, true);
+			}
+
+			return Detail::AsciiSizeHint<CodePageValue>(
+			    Detail::GetFloatingLengthBound(value, option), false);
+		}
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, OutputSink Sink>
+		static constexpr FormatErrorCode
+		IntegerToString(T value, Encoding::StringView<CodePageValue> const& formatOption,
+		                Sink& sink)
+		{
+			IntegerFormatOption option;
+			if (const auto result =
+			        IntegerFormatOption::TryParse<ErrorPolicy>(formatOption, option);
+			    result != FormatErrorCode::Success)
+			{
+				return result;
+			}
+
+			return IntegerToString(value, option, sink);
+		}
+
+		template <typename T, OutputSink Sink>
+		static constexpr FormatErrorCode IntegerToString(T value, IntegerFormatOption const& option,
+		                                                 Sink& sink)
+		{
+			constexpr auto CodePageValue = Sink::UsingCodePage;
+			assert(2 <= option.Base && option.Base <= 36);
+
+			// 取绝对值时转换到无符号数，因此最小值无需特殊处理
+			const auto [isNegative, magnitude] = Detail::SplitSign(value);
+
+			if constexpr (IsAsciiCompatible<CodePageValue> && !Detail::AsciiAppendableSink<Sink>)
+			{
+				// 长度可预先得到，直接写入目标编码单元
+				const auto length = isNegative + Detail::CountDigits(magnitude, option.Base);
+				const auto buffer = sink.Reserve(length);
+				Detail::WriteIntegerBackward(buffer.data() + length, isNegative, magnitude,
+				                             option.Base, option.UseUppercase);
+				sink.Commit(length);
+			}
+			else
+			{
+				char buffer[Detail::MaxIntegerLength];
+				const auto end = buffer + Detail::MaxIntegerLength;
+				const auto begin = Detail::WriteIntegerBackward(end, isNegative, magnitude,
+				                                                option.Base, option.UseUppercase);
+				Detail::EmitAscii<CodePageValue>(std::span<const char>(begin, end), sink);
+			}
+
+			return FormatErrorCode::Success;
+		}
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, OutputSink Sink>
+		static FormatErrorCode
+		FloatingToString(T value, Encoding::StringView<CodePageValue> const& formatOption,
+		                 Sink& sink)
+		{
+			FloatingFormatOption option;
+			if (const auto result =
+			        FloatingFormatOption::TryParse<ErrorPolicy>(formatOption, option);
+			    result != FormatErrorCode::Success)
+			{
+				return result;
+			}
+
+			return FloatingToString(value, option, sink);
+		}
+
+		template <typename T, OutputSink Sink>
+		static FormatErrorCode FloatingToString(T value, FloatingFormatOption const& option,
+		                                        Sink& sink)
+		{
+			constexpr auto CodePageValue = Sink::UsingCodePage;
+			using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+			if (value != value)
+			{
+				// 是 NaN
+				constexpr char NanStr[] = { 'N', 'a', 'N' };
+				Detail::EmitAscii<CodePageValue>(NanStr, sink);
+				return FormatErrorCode::Success;
+			}
+
+			if (value == std::numeric_limits<T>::infinity() ||
+			    value == -std::numeric_limits<T>::infinity())
+			{
+				constexpr char InfinityStr[] = { '-', 'I', 'n', 'f', 'i', 'n', 'i', 't', 'y' };
+				Detail::EmitAscii<CodePageValue>(std::span(InfinityStr).subspan(value > 0), sink);
+				return FormatErrorCode::Success;
+			}
+
+			if constexpr (IsAsciiCompatible<CodePageValue> && sizeof(CharType) == sizeof(char) &&
+			              !Detail::AsciiAppendableSink<Sink>)
+			{
+				// 直接写入目标编码单元，char 可访问任意对象的存储
+				const auto buffer = sink.Reserve(Detail::GetFloatingLengthBound(value, option));
+				const auto begin = reinterpret_cast<char*>(buffer.data());
+				const auto end = Detail::WriteFloating(begin, begin + buffer.size(), value, option);
+				if (!end)
+				{
+					sink.Commit(0);
+					return ErrorPolicy::OnFormatError(FormatErrorCode::BufferTooSmall);
+				}
+				sink.Commit(static_cast<std::size_t>(end - begin));
+			}
+			else
+			{
+				char buffer[Detail::MaxFloatingLength<T>];
+				const auto end = Detail::WriteFloating(
+				    buffer, buffer + Detail::MaxFloatingLength<T>, value, option);
+				if (!end)
+				{
+					return ErrorPolicy::OnFormatError(FormatErrorCode::BufferTooSmall);
+				}
+				Detail::EmitAscii<CodePageValue>(std::span<const char>(buffer, end), sink);
+			}
+
+			return FormatErrorCode::Success;
+		}
+	};
+
+	using DefaultStringConverter = BasicDefaultStringConverter<>;
+
+	/// @brief  使用 std::to_chars 转换数值的转换器，接受与 DefaultStringConverter 相同的格式化选项
+	/// @remark 结果写入栈上缓冲区后直接扩展到目标编码，不分配内存，可代替 StringStreamStringConverter
+	///         及 StdToStringStringConverter，不能在编译期求值
+	///         数值以外的类型交由 BasicDefaultStringConverter 处理，ErrorPolicy 的含义与其相同
+	template <typename ErrorPolicy = ThrowOnFormatErrorPolicy>
+	struct BasicCharsStringConverter
+	{
+		using FormatErrorPolicy = ErrorPolicy;
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		static FormatErrorCode
+		ToString(T const& value, Encoding::StringView<CodePageValue> const& formatOption,
+		         Output&& output) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				auto result = FormatErrorCode::Success;
+				Detail::WithOutputSink<CodePageValue>(output, [&](auto& sink) {
+					result = IntegerToString(value, formatOption, sink);
+				});
+				return result;
+			}
+			else
+			{
+				// 浮点数已经使用 std::to_chars
+				return BasicDefaultStringConverter<ErrorPolicy>::ToString(value, formatOption,
+				                                                          output);
+			}
+		}
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		static FormatErrorCode
+		ToString(T const& value, PreparedFormatOption<CodePageValue> const& formatOption,
+		         Output&& output) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				if (formatOption.Integer)
+				{
+					auto result = FormatErrorCode::Success;
+					Detail::WithOutputSink<CodePageValue>(output, [&](auto& sink) {
+						result = IntegerToString(value, *formatOption.Integer, sink);
+					});
+					return result;
+				}
+
+				return ToString(value, formatOption.Text, output);
+			}
+			else
+			{
+				return BasicDefaultStringConverter<ErrorPolicy>::ToString(value, formatOption,
+				                                                          output);
+			}
+		}
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatSizeHint
+		GetSizeHint(T const& value,
+		            Encoding::StringView<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			return BasicDefaultStringConverter<ErrorPolicy>::GetSizeHint(value, formatOption);
+		}
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatSizeHint
+		GetSizeHint(T const& value,
+		            PreparedFormatOption<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			return BasicDefaultStringConverter<ErrorPolicy>::GetSizeHint(value, formatOption);
+		}
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatErrorCode
+		CheckFormatOption(Encoding::StringView<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			return BasicDefaultStringConverter<ErrorPolicy>::template CheckFormatOption<T>(
+			    formatOption);
+		}
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue>
+		static constexpr FormatErrorCode
+		CheckFormatOption(PreparedFormatOption<CodePageValue> const& formatOption) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			return BasicDefaultStringConverter<ErrorPolicy>::template CheckFormatOption<T>(
+			    formatOption);
+		}
+
+	private:
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, OutputSink Sink>
+		static FormatErrorCode
+		IntegerToString(T value, Encoding::StringView<CodePageValue> const& formatOption,
+		                Sink& sink)
+		{
+			IntegerFormatOption option;
+			if (const auto result =
+			        IntegerFormatOption::TryParse<ErrorPolicy>(formatOption, option);
+			    result != FormatErrorCode::Success)
+			{
+				return result;
+			}
+
+			return IntegerToString(value, option, sink);
+		}
+
+		template <typename T, OutputSink Sink>
+		static FormatErrorCode IntegerToString(T value, IntegerFormatOption const& option,
+		                                       Sink& sink)
+		{
+			constexpr auto CodePageValue = Sink::UsingCodePage;
+			using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+			// bool 及字符类型不被 std::to_chars 接受
+			using ValueType =
+			    std::conditional_t<std::is_signed_v<T>, std::intmax_t, std::uintmax_t>;
+
+			const auto write = [&](char* begin) {
+				const auto end = std::to_chars(begin, begin + Detail::MaxIntegerLength,
+				                               static_cast<ValueType>(value),
+				                               static_cast<int>(option.Base))
+				                     .ptr;
+				if (option.UseUppercase)
+				{
+					std::transform(begin, end, begin, [](char c) {
+						return 'a' <= c && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+					});
+				}
+				return end;
+			};
+
+			if constexpr (IsAsciiCompatible<CodePageValue> && sizeof(CharType) == sizeof(char) &&
+			              !Detail::AsciiAppendableSink<Sink>)
+			{
+				// 直接写入目标编码单元，char 可访问任意对象的存储
+				const auto buffer = sink.Reserve(Detail::MaxIntegerLength);
+				const auto begin = reinterpret_cast<char*>(buffer.data());
+				sink.Commit(static_cast<std::size_t>(write(begin) - begin));
+			}
+			else
+			{
+				char buffer[Detail::MaxIntegerLength];
+				Detail::EmitAscii<CodePageValue>(std::span<const char>(buffer, write(buffer)),
+				                                 sink);
+			}
+
+			return FormatErrorCode::Success;
+		}
+	};
+
+	using CharsStringConverter = BasicCharsStringConverter<>;
+
+	/// @remark 每次转换均会分配内存，建议使用 CharsStringConverter
+	struct StringStreamStringConverter
+	{
+	private:
+		std::stringstream m_InternalBuffer;
+
+	public:
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		void ToString(T const& value,
+		              [[maybe_unused]] Encoding::StringView<CodePageValue> const& formatOption,
+		              Output&& output)
+		{
+			m_InternalBuffer << value;
+			const auto tmpStr = EncodeFromNarrow<CodePageValue>(m_InternalBuffer.str());
+			Detail::WithOutputSink<CodePageValue>(
+			    output, [&](auto& sink) { sink.Append(tmpStr.GetView().GetTrimmedSpan()); });
+			m_InternalBuffer.str({});
+			m_InternalBuffer.clear();
+		}
+	};
+
+	/// @remark 每次转换均会分配内存，建议使用 CharsStringConverter
+	struct StdToStringStringConverter
+	{
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		void ToString(T const& value,
+		              [[maybe_unused]] Encoding::StringView<CodePageValue> const& formatOption,
+		              Output&& output)
+		{
+			const auto result = std::to_string(value);
+			const auto tmpStr = EncodeFromNarrow<CodePageValue>(result);
+			Detail::WithOutputSink<CodePageValue>(
+			    output, [&](auto& sink) { sink.Append(tmpStr.GetView().GetTrimmedSpan()); });
+		}
+	};
+
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	struct FormatInfo
+	{
+		std::size_t Index;
+		Encoding::StringView<CodePageValue> FormatOptionText;
+	};
+
+	/// @brief  默认的格式串分析器，ErrorPolicy 决定格式串无效时的处理方式
+	/// @remark ErrorPolicy 不抛出异常时，出错后跳过剩余的全部格式串，错误可由 GetError 获得
+	template <typename ErrorPolicy = ThrowOnFormatErrorPolicy>
+	struct BasicDefaultFormatter
+	{
+		using FormatErrorPolicy = ErrorPolicy;
+
+		static constexpr Encoding::CodePointType FormatPrefix{ '$' };
+		static constexpr Encoding::CodePointType FormatLeftQuote{ '{' };
+		static constexpr Encoding::CodePointType FormatOptionToken{ ':' };
+		static constexpr Encoding::CodePointType FormatRightQuote{ '}' };
+
+		constexpr BasicDefaultFormatter() noexcept
+		    : m_CurrentMode{ Mode::Unknown }, m_CurrentIndex{}, m_Error{ FormatErrorCode::Success }
+		{
+		}
+
+		/// @brief  获得分析中出现的错误
+		constexpr FormatErrorCode GetError() const noexcept
+		{
+			return m_Error;
+		}
+
+	private:
+		enum class Mode
+		{
+			Unknown,
+			IndexMode,
+			AutoMode,
+		};
+
+		Mode m_CurrentMode;
+
+		// 不使用索引时自动增加索引并选择参数，不可与使用索引混用
+		std::size_t m_CurrentIndex;
+
+		FormatErrorCode m_Error;
+
+		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
 		static constexpr std::pair<bool, std::size_t>
 		BeginWith(Encoding::StringView<CodePageValue, Extent> const& format,
 		          Encoding::CodePointType codePoint) noexcept
 		{
-			if (format.IsEmpty())
+			if (format.IsEmpty())
+			{
+				return { false, 0 };
+			}
+
+			using Trait = Encoding::CodePage::CodePageTrait<CodePageValue>;
+			std::pair<bool, std::size_t> result;
+			Trait::ToCodePoint(format.GetSpan(), [&](auto const& encodingResult) {
+				if constexpr (Encoding::GetEncodingResultCode<decltype(encodingResult)> ==
+				              Encoding::EncodingResultCode::Accept)
+				{
+					result = { encodingResult.Result == codePoint, encodingResult.AdvanceCount };
+				}
+				else
+				{
+					result = { false, 1 };
+				}
+			});
+
+			return result;
+		}
+
+		/// @remark 运行期查找 ASCII 码点且编码兼容 ASCII 时不进行解码，直接扫描编码单元
+		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+		static constexpr std::size_t SkipUntil(Encoding::StringView<CodePageValue, Extent> format,
+		                                       Encoding::CodePointType codePoint) noexcept
+		{
+			if (format.IsEmpty())
+			{
+				return 0;
+			}
+
+			using Trait = Encoding::CodePage::CodePageTrait<CodePageValue>;
+			if constexpr (IsAsciiCompatible<CodePageValue>)
+			{
+				if (!std::is_constant_evaluated() && codePoint < 0x80)
+				{
+					return Detail::FindAsciiUnit(
+					    std::span<const typename Trait::CharType>(format.GetSpan()),
+					    static_cast<char>(codePoint));
+				}
+			}
+
+			std::size_t result{};
+			auto shouldStop = false;
+			do
+			{
+				Trait::ToCodePoint(format.GetSpan(), [&](auto const& encodingResult) {
+					if constexpr (Encoding::GetEncodingResultCode<decltype(encodingResult)> ==
+					              Encoding::EncodingResultCode::Accept)
+					{
+						shouldStop = encodingResult.Result == codePoint;
+						// 到匹配之时即停止，不消费匹配的值
+						if (!shouldStop)
+						{
+							result += encodingResult.AdvanceCount;
+							format = format.SubStr(encodingResult.AdvanceCount);
+						}
+					}
+					else
+					{
+						// 编码失败，此时不与要寻找的值匹配因此增加并继续
+						++result;
+						format = format.SubStr(1);
+					}
+				});
+			} while (!shouldStop && !format.IsEmpty());
+			return result;
+		}
+
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		constexpr std::pair<FormatInfo<CodePageValue>, std::size_t>
+		Fail(FormatErrorCode code) noexcept(NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			m_Error = ErrorPolicy::OnFormatError(code);
+			return {};
+		}
+
+		/// @remark 出错时设置 m_Error，返回值无意义
+		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+		constexpr std::pair<FormatInfo<CodePageValue>, std::size_t>
+		ParseFormatInfo(Encoding::StringView<CodePageValue, Extent> const& format) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			Encoding::StringView<CodePageValue> formatStr = format;
+			const auto begin = formatStr.begin();
+			FormatInfo<CodePageValue> result{};
+
+			const auto beginWithFormatLeftQuote = BeginWith(formatStr, FormatLeftQuote);
+			if (!beginWithFormatLeftQuote.first)
+			{
+				return Fail<CodePageValue>(FormatErrorCode::InvalidFormatString);
+			}
+
+			formatStr = formatStr.SubStr(beginWithFormatLeftQuote.second);
+
+			auto indexBegin = formatStr.begin();
+			while (true)
+			{
+				if (formatStr.IsEmpty())
+				{
+					return Fail<CodePageValue>(FormatErrorCode::InvalidFormatString);
+				}
+
+				const auto prevPos = formatStr.begin();
+				const auto beginWithFormatOptionToken = BeginWith(formatStr, FormatOptionToken);
+				auto parseFormatOption = true;
+				if (beginWithFormatOptionToken.first)
+				{
+					formatStr = formatStr.SubStr(beginWithFormatOptionToken.second);
+				}
+				else
+				{
+					const auto beginWithFormatRightQuote = BeginWith(formatStr, FormatRightQuote);
+					formatStr = formatStr.SubStr(beginWithFormatRightQuote.second);
+					if (beginWithFormatRightQuote.first)
+					{
+						parseFormatOption = false;
+					}
+					else
+					{
+						continue;
+					}
+				}
+
+				if (indexBegin == prevPos)
+				{
+					if constexpr (ErrorPolicy::CheckFormat)
+					{
+						if (m_CurrentMode == Mode::IndexMode)
+						{
+							return Fail<CodePageValue>(FormatErrorCode::InvalidFormatString);
+						}
+					}
+
+					m_CurrentMode = Mode::AutoMode;
+				}
+				else
+				{
+					if constexpr (ErrorPolicy::CheckFormat)
+					{
+						if (m_CurrentMode == Mode::AutoMode)
+						{
+							return Fail<CodePageValue>(FormatErrorCode::InvalidFormatString);
+						}
+					}
+
+					m_CurrentMode = Mode::IndexMode;
+				}
+
+				if (m_CurrentMode == Mode::IndexMode)
+				{
+					const auto [parsedIndex, parsedCount, overflowed] =
+					    AsciiToNumberWithOverflow(Encoding::StringView<CodePageValue, Extent>{
+					        std::span(indexBegin, prevPos) });
+
+					if constexpr (ErrorPolicy::CheckFormat)
+					{
+						if (overflowed || parsedCount != static_cast<std::size_t>(
+						                                     std::distance(indexBegin, prevPos)))
+						{
+							return Fail<CodePageValue>(FormatErrorCode::InvalidFormatString);
+						}
+					}
+
+					result.Index = parsedIndex;
+				}
+				else
+				{
+					assert(m_CurrentMode == Mode::AutoMode);
+					result.Index = m_CurrentIndex++;
+				}
+
+				if (parseFormatOption)
+				{
+					const auto formatOptionBegin = formatStr.begin();
+					while (true)
+					{
+						if (formatStr.IsEmpty())
+						{
+							return Fail<CodePageValue>(FormatErrorCode::InvalidFormatString);
+						}
+
+						const auto beginWithFormatRightQuote =
+						    BeginWith(formatStr, FormatRightQuote);
+						const auto curPos = formatStr.begin();
+						formatStr = formatStr.SubStr(beginWithFormatRightQuote.second);
+						if (beginWithFormatRightQuote.first)
+						{
+							result.FormatOptionText = Encoding::StringView<CodePageValue, Extent>{
+								std::span(formatOptionBegin, curPos)
+							};
+							break;
+						}
+					}
+				}
+
+				break;
+			}
+
+			return { result, std::distance(begin, formatStr.begin()) };
+		}
+
+	public:
+		/// @brief  尝试分析格式化信息
+		/// @return 格式化信息、消耗的编码单元个数、跳过的编码单元个数
+		///         跳过的编码单元不计入消耗之中，将会直接跳过，为了处理 escape
+		///         出错且未抛出异常时跳过剩余的全部格式串
+		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+		constexpr std::tuple<std::optional<FormatInfo<CodePageValue>>, std::size_t, std::size_t>
+		TryParseFormatInfo(Encoding::StringView<CodePageValue, Extent> const& format) noexcept(
+		    NoexceptFormatErrorPolicy<ErrorPolicy>)
+		{
+			if (m_Error != FormatErrorCode::Success)
+			{
+				return { {}, 0, format.GetSize() };
+			}
+
+			const auto beginWithFormatPrefix = BeginWith(format, FormatPrefix);
+			if (!beginWithFormatPrefix.first)
+			{
+				const auto skippedLength =
+				    SkipUntil(format.SubStr(beginWithFormatPrefix.second), FormatPrefix);
+				return { {}, beginWithFormatPrefix.second + skippedLength, 0 };
+			}
+
+			const auto restFormat = format.SubStr(beginWithFormatPrefix.second);
+			const auto [secondIsFormatPrefix, consumedCount] = BeginWith(restFormat, FormatPrefix);
+			// 下一个仍然是 FormatPrefix，作为 escape 被跳过
+			if (secondIsFormatPrefix)
+			{
+				return { {}, consumedCount, beginWithFormatPrefix.second };
+			}
+
+			auto result = ParseFormatInfo(restFormat);
+			if (m_Error != FormatErrorCode::Success)
+			{
+				return { {}, 0, format.GetSize() };
+			}
+			return { std::move(result.first), beginWithFormatPrefix.second + result.second, 0 };
+		}
+	};
+
+	using DefaultFormatter = BasicDefaultFormatter<>;
+
+	/// @brief  预先分析的格式串中的一段，为字面文本或格式化参数之一
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	struct FormatSegment
+	{
+		// 字面文本，为参数时为空
+		Encoding::StringView<CodePageValue> LiteralText;
+		// 格式化参数的信息，为字面文本时为空
+		std::optional<FormatInfo<CodePageValue>> ArgumentInfo;
+		// 分析格式串时预先分析的格式化选项，为字面文本时为空
+		PreparedFormatOption<CodePageValue> PreparedOption;
+	};
+
+	namespace Detail
+	{
+		/// @brief  使用 formatter 分析整个格式串，并按顺序对每一段调用 segmentReceiver
+		/// @remark 相邻的字面文本（例如 escape 的前后）将合并为一段，空终止符不视为格式文本的一部分
+		template <typename Formatter, Encoding::CodePage::CodePageType CodePageValue,
+		          std::size_t Extent, typename SegmentReceiver>
+		constexpr void
+		ParseFormatSegments(Formatter&& formatter,
+		                    Encoding::StringView<CodePageValue, Extent> const& format,
+		                    SegmentReceiver&& segmentReceiver)
+		{
+			auto formatStr = Encoding::StringView<CodePageValue>{ format }.Trim();
+			Encoding::StringView<CodePageValue> pendingLiteral;
+			const auto flushPendingLiteral = [&] {
+				if (!pendingLiteral.IsEmpty())
+				{
+					segmentReceiver(FormatSegment<CodePageValue>{ pendingLiteral, {}, {} });
+					pendingLiteral = {};
+				}
+			};
+
+			while (true)
+			{
+				const auto [formatInfo, advanceCount, skippedCount] =
+				    std::forward<Formatter>(formatter).TryParseFormatInfo(formatStr);
+				formatStr = formatStr.SubStr(skippedCount);
+				const auto literalText = formatStr.SubStr(0, advanceCount);
+				formatStr = formatStr.SubStr(advanceCount);
+				if (formatInfo.has_value())
+				{
+					flushPendingLiteral();
+					segmentReceiver(FormatSegment<CodePageValue>{
+					    {},
+					    formatInfo,
+					    PreparedFormatOption<CodePageValue>::Prepare(
+					        formatInfo->FormatOptionText) });
+				}
+				else if (advanceCount)
+				{
+					if (!pendingLiteral.IsEmpty() &&
+					    pendingLiteral.GetData() + pendingLiteral.GetSize() ==
+					        literalText.GetData())
+					{
+						pendingLiteral = Encoding::StringView<CodePageValue>{ std::span(
+						    pendingLiteral.GetData(),
+						    pendingLiteral.GetSize() + literalText.GetSize()) };
+					}
+					else
+					{
+						flushPendingLiteral();
+						pendingLiteral = literalText;
+					}
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			flushPendingLiteral();
+		}
+
+		/// @remark 转换器不接受预先分析的格式化选项时检查选项的文本
+		template <typename StringConverter, typename T, typename FormatOption>
+		constexpr void CheckFormatOption(FormatOption const& formatOption)
+		{
+			if constexpr (IsPreparedFormatOption<FormatOption> && !requires {
+				              StringConverter::template CheckFormatOption<T>(formatOption);
+			              })
+			{
+				CheckFormatOption<StringConverter, T>(formatOption.Text);
+			}
+			else if constexpr (requires {
+				                   StringConverter::template CheckFormatOption<T>(formatOption);
+			                   })
+			{
+				// 不抛出异常的转换器返回错误码，仍然视为检查失败
+				if constexpr (std::is_same_v<
+				                  decltype(StringConverter::template CheckFormatOption<T>(
+				                      formatOption)),
+				                  FormatErrorCode>)
+				{
+					if (const auto result =
+					        StringConverter::template CheckFormatOption<T>(formatOption);
+					    result != FormatErrorCode::Success)
+					{
+						ThrowOnFormatErrorPolicy::OnFormatError(result);
+					}
+				}
+				else
+				{
+					StringConverter::template CheckFormatOption<T>(formatOption);
+				}
+			}
+		}
+	} // namespace Detail
+
+	/// @brief  计算格式串分析后的段数，用于确定 CompiledFormat 的大小
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+	consteval std::size_t
+	CountFormatSegments(Encoding::StringView<CodePageValue, Extent> const& format)
+	{
+		std::size_t count{};
+		Detail::ParseFormatSegments(DefaultFormatter{}, format, [&](auto const&) { ++count; });
+		return count;
+	}
+
+	/// @brief  编译期分析完成的格式串
+	/// @remark 仅引用原格式串的内容，因此原格式串必须具有静态存储期，通常应当由字面量构造
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t SegmentCount>
+	class CompiledFormat
+	{
+	public:
+		static constexpr auto UsingCodePage = CodePageValue;
+
+		template <std::size_t Extent>
+		explicit consteval CompiledFormat(Encoding::StringView<CodePageValue, Extent> const& format)
+		    : m_Segments{}
+		{
+			std::size_t segmentCount{};
+			Detail::ParseFormatSegments(DefaultFormatter{}, format, [&](auto const& segment) {
+				if (segmentCount == SegmentCount)
+				{
+					CAFE_THROW(FormatException, CAFE_UTF8_SV("Segment count mismatch."));
+				}
+				m_Segments[segmentCount++] = segment;
+			});
+
+			if (segmentCount != SegmentCount)
+			{
+				CAFE_THROW(FormatException, CAFE_UTF8_SV("Segment count mismatch."));
+			}
+		}
+
+		constexpr std::span<const FormatSegment<CodePageValue>> GetSegments() const noexcept
+		{
+			return m_Segments;
+		}
+
+	private:
+		std::array<FormatSegment<CodePageValue>, SegmentCount> m_Segments;
+	};
+
+	template <std::size_t SegmentCount, Encoding::CodePage::CodePageType CodePageValue,
+	          std::size_t Extent>
+	consteval CompiledFormat<CodePageValue, SegmentCount>
+	CompileFormat(Encoding::StringView<CodePageValue, Extent> const& format)
+	{
+		return CompiledFormat<CodePageValue, SegmentCount>{ format };
+	}
+
+	/// @brief  将编译期分析的格式串绑定到类型上，以便在格式化时检查参数
+	/// @remark 应当通过 CAFE_COMPILE_FORMAT 构造
+	template <typename FormatProvider>
+	struct StaticCompiledFormat
+	{
+		static constexpr auto Value = FormatProvider{}();
+		static constexpr auto UsingCodePage = decltype(Value)::UsingCodePage;
+
+		constexpr explicit StaticCompiledFormat(FormatProvider) noexcept
+		{
+		}
+
+		constexpr std::span<const FormatSegment<UsingCodePage>> GetSegments() const noexcept
+		{
+			return Value.GetSegments();
+		}
+	};
+
+/// @brief  在编译期分析格式串，结果可直接传入 FormatString 等函数
+/// @remark 格式串有误、混用索引与自动索引、索引越界及格式化选项不适用于对应参数时均产生编译错误
+#define CAFE_COMPILE_FORMAT(format)                                                                \
+	(::Cafe::TextUtils::StaticCompiledFormat{ [] {                                                 \
+		constexpr auto cafeCompiledFormatString_ = format;                                         \
+		return ::Cafe::TextUtils::CompileFormat<::Cafe::TextUtils::CountFormatSegments(            \
+		    cafeCompiledFormatString_)>(cafeCompiledFormatString_);                                \
+	} })
+
+	/// @brief  已预先分析的格式串，可直接按段进行格式化
+	template <typename T>
+	concept PreparedFormat = requires(T const& format)
+	{
+		T::UsingCodePage;
+		{ format.GetSegments() }
+		    -> std::convertible_to<std::span<const FormatSegment<T::UsingCodePage>>>;
+	};
+
+	namespace Detail
+	{
+		template <typename T>
+		constexpr bool IsStaticCompiledFormat = false;
+
+		template <typename FormatProvider>
+		constexpr bool IsStaticCompiledFormat<StaticCompiledFormat<FormatProvider>> = true;
+
+		/// @brief  检查各参数段的索引是否越界，以及格式化选项是否适用于对应的参数类型
+		template <typename StringConverter, typename... Args,
+		          Encoding::CodePage::CodePageType CodePageValue>
+		constexpr void CheckFormatSegments(std::span<const FormatSegment<CodePageValue>> segments)
+		{
+			for (auto const& segment : segments)
+			{
+				if (!segment.ArgumentInfo.has_value())
+				{
+					continue;
+				}
+
+				const auto& info = *segment.ArgumentInfo;
+				if (info.Index >= sizeof...(Args))
+				{
+					CAFE_THROW(FormatException, CAFE_UTF8_SV("Index out of range."));
+				}
+
+				[&]<std::size_t... I>(std::index_sequence<I...>)
+				{
+					((info.Index == I
+					      ? CheckFormatOption<StringConverter,
+					                          std::tuple_element_t<I, std::tuple<Args...>>>(
+					            segment.PreparedOption)
+					      : void()),
+					 ...);
+				}
+				(std::index_sequence_for<Args...>{});
+			}
+		}
+
+		template <typename StringConverter, typename Format, typename... Args>
+		consteval bool CheckStaticCompiledFormat()
+		{
+			CheckFormatSegments<StringConverter, Args...>(Format::Value.GetSegments());
+			return true;
+		}
+	} // namespace Detail
+
+	namespace Detail
+	{
+		template <typename StringConverter, typename T,
+		          Encoding::CodePage::CodePageType CodePageValue>
+		constexpr FormatSizeHint
+		GetSizeHint(StringConverter&& stringConverter, T const& value,
+		            Encoding::StringView<CodePageValue> const& formatOption)
+		{
+			if constexpr (requires { stringConverter.GetSizeHint(value, formatOption); })
+			{
+				return stringConverter.GetSizeHint(value, formatOption);
+			}
+			else
+			{
+				return { 0, false };
+			}
+		}
+
+		/// @brief  转换器接受预先分析的格式化选项时直接传递，否则传递选项的文本
+		template <typename StringConverter, typename T,
+		          Encoding::CodePage::CodePageType CodePageValue>
+		constexpr FormatSizeHint
+		GetSizeHint(StringConverter&& stringConverter, T const& value,
+		            PreparedFormatOption<CodePageValue> const& formatOption)
+		{
+			if constexpr (requires { stringConverter.GetSizeHint(value, formatOption); })
+			{
+				return stringConverter.GetSizeHint(value, formatOption);
+			}
+			else
+			{
+				return GetSizeHint(stringConverter, value, formatOption.Text);
+			}
+		}
+
+		/// @brief  由已分析的格式串得到格式化结果的长度提示，不产生任何结果
+		template <typename StringConverter, PreparedFormat Format, typename... Args>
+		constexpr FormatSizeHint GetFormatSizeHint(StringConverter&& stringConverter,
+		                                           Format const& format, Args const&... args)
+		{
+			FormatSizeHint result{ 0, true };
+			const auto argsTuple = std::forward_as_tuple(args...);
+			for (auto const& segment : format.GetSegments())
+			{
+				if (segment.ArgumentInfo.has_value())
+				{
+					const auto& info = *segment.ArgumentInfo;
+					if (!Core::Misc::RuntimeGet(info.Index, argsTuple, [&](auto const& item) {
+						    result += GetSizeHint(stringConverter, item, segment.PreparedOption);
+					    }))
+					{
+						result.IsExact = false;
+					}
+				}
+				else
+				{
+					result.Size += segment.LiteralText.GetSize();
+				}
+			}
+			return result;
+		}
+
+		/// @brief  在不分析格式串的情况下估计格式化结果的长度
+		/// @remark 此时无法得知参数的引用次数及格式化选项，以格式串的长度加上各参数以默认选项格式化的长度作为估计
+		template <typename StringConverter, Encoding::CodePage::CodePageType CodePageValue,
+		          std::size_t Extent, typename... Args>
+		constexpr FormatSizeHint
+		EstimateFormatSize(StringConverter&& stringConverter,
+		                   Encoding::StringView<CodePageValue, Extent> const& format,
+		                   Args const&... args)
+		{
+			FormatSizeHint result{ format.GetSize(), false };
+			((result += GetSizeHint(stringConverter, args, Encoding::StringView<CodePageValue>{})),
+			 ...);
+			result.IsExact = false;
+			return result;
+		}
+	} // namespace Detail
+
+	/// @brief  运行期分析的格式串，适用于无法在编译期确定的格式串，分析一次后可多次用于格式化
+	/// @remark 本类不取得格式串的所有权，仅引用格式串的内容，
+	///         因此必须由用户保证格式串的生命期在本类的生命期全程都有效
+	///         各参数的格式化选项在构造时一并分析，Check 及格式化时直接使用分析的结果
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	class FormatTemplate
+	{
+	public:
+		static constexpr auto UsingCodePage = CodePageValue;
+
+		/// @brief  分析格式串，格式串有误时抛出 FormatException
+		template <std::size_t Extent>
+		explicit FormatTemplate(Encoding::StringView<CodePageValue, Extent> const& format)
+		    : m_ArgumentCount{}
+		{
+			Detail::ParseFormatSegments(DefaultFormatter{}, format, [&](auto const& segment) {
+				if (segment.ArgumentInfo.has_value())
+				{
+					m_ArgumentCount = std::max(m_ArgumentCount, segment.ArgumentInfo->Index + 1);
+				}
+				m_Segments.push_back(segment);
+			});
+		}
+
+		std::span<const FormatSegment<CodePageValue>> GetSegments() const noexcept
+		{
+			return m_Segments;
+		}
+
+		/// @brief  获得格式串引用的参数个数，即最大的索引加 1
+		std::size_t GetArgumentCount() const noexcept
+		{
+			return m_ArgumentCount;
+		}
+
+		/// @brief  检查本格式串能否以 StringConverter 格式化类型为 Args 的参数，不能时抛出 FormatException
+		/// @remark 可用于在加载格式串时提前发现错误，而不是等到格式化时
+		///         与 FormatStringWithCustomConverter 一致，StringConverter 位于参数类型之前，
+		///         使用默认的转换器时应指定 DefaultStringConverter
+		template <typename StringConverter, typename... Args>
+		void Check() const
+		{
+			Detail::CheckFormatSegments<StringConverter, Args...>(GetSegments());
+		}
+
+	private:
+		std::vector<FormatSegment<CodePageValue>> m_Segments;
+		std::size_t m_ArgumentCount;
+	};
+
+	namespace Detail
+	{
+		template <typename T>
+		struct FormatErrorPolicyOf
+		{
+			using Type = ThrowOnFormatErrorPolicy;
+		};
+
+		template <typename T>
+		requires requires
+		{
+			typename T::FormatErrorPolicy;
+		}
+		struct FormatErrorPolicyOf<T>
+		{
+			using Type = typename T::FormatErrorPolicy;
+		};
+
+		/// @brief  获得 T 的 FormatErrorPolicy 成员类型，没有时为 ThrowOnFormatErrorPolicy
+		template <typename T>
+		using GetFormatErrorPolicy = typename FormatErrorPolicyOf<Core::Misc::RemoveCvRef<T>>::Type;
+
+		/// @brief  调用转换器格式化 value，转换器不返回错误码时视为成功
+		template <typename StringConverter, typename T, typename FormatOption, typename Sink>
+		constexpr FormatErrorCode ConvertArgument(StringConverter&& stringConverter, T const& value,
+		                                          FormatOption const& formatOption, Sink& sink)
+		{
+			if constexpr (IsPreparedFormatOption<FormatOption> &&
+			              !requires {
+				              std::forward<StringConverter>(stringConverter)
+				                  .ToString(value, formatOption, sink);
+			              })
+			{
+				// 转换器不接受预先分析的格式化选项时传递选项的文本
+				return ConvertArgument(std::forward<StringConverter>(stringConverter), value,
+				                       formatOption.Text, sink);
+			}
+			else if constexpr (std::is_same_v<
+			                       decltype(std::forward<StringConverter>(stringConverter)
+			                                    .ToString(value, formatOption, sink)),
+			                       FormatErrorCode>)
+			{
+				return std::forward<StringConverter>(stringConverter)
+				    .ToString(value, formatOption, sink);
+			}
+			else
+			{
+				std::forward<StringConverter>(stringConverter).ToString(value, formatOption, sink);
+				return FormatErrorCode::Success;
+			}
+		}
+	} // namespace Detail
+
+	/// @param  output  OutputSink，或以 span 为参数的接收器
+	/// @return formatter 或 stringConverter 不抛出异常时返回遇到的错误，否则总是返回 FormatErrorCode::Success
+	///         索引越界按 formatter 的 FormatErrorPolicy 处理
+	template <typename Output, typename Formatter, typename StringConverter,
+	          Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	constexpr FormatErrorCode FormatStringWithCustomFormatter(
+	    Output&& output, Formatter&& formatter, StringConverter&& stringConverter,
+	    Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	{
+		auto result = FormatErrorCode::Success;
+		Detail::WithOutputSink<CodePageValue>(output, [&](auto& sink) {
+			Encoding::StringView<CodePageValue> formatStr = format;
+			const auto argsTuple = std::forward_as_tuple(args...);
+			while (true)
+			{
+				const auto [formatInfo, advanceCount, skippedCount] =
+				    std::forward<Formatter>(formatter).TryParseFormatInfo(formatStr);
+				formatStr = formatStr.SubStr(skippedCount);
+				const auto prevPos = formatStr.begin();
+				formatStr = formatStr.SubStr(advanceCount);
+				if (formatInfo.has_value())
+				{
+					const auto info = formatInfo.value();
+					if (!Core::Misc::RuntimeGet(info.Index, argsTuple, [&](auto const& item) {
+						    result = Detail::ConvertArgument(
+						        std::forward<StringConverter>(stringConverter), item,
+						        info.FormatOptionText, sink);
+					    }))
+					{
+						result = Detail::GetFormatErrorPolicy<Formatter>::OnFormatError(
+						    FormatErrorCode::IndexOutOfRange);
+					}
+
+					if (result != FormatErrorCode::Success)
+					{
+						return;
+					}
+				}
+				else if (prevPos != formatStr.end())
+				{
+					sink.Append(Encoding::StringView<CodePageValue>{
+					    std::span(prevPos, formatStr.begin()) }
+					                .GetTrimmedSpan());
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			if constexpr (requires { formatter.GetError(); })
+			{
+				result = formatter.GetError();
+			}
+		});
+		return result;
+	}
+
+	/// @param  output  OutputSink，或以 span 为参数的接收器
+	/// @return stringConverter 不抛出异常时返回遇到的错误，否则总是返回 FormatErrorCode::Success
+	///         索引越界按 stringConverter 的 FormatErrorPolicy 处理
+	template <typename Output, typename StringConverter, PreparedFormat Format, typename... Args>
+	constexpr FormatErrorCode FormatStringWithCustomConverter(Output&& output,
+	                                                          StringConverter&& stringConverter,
+	                                                          Format const& format,
+	                                                          Args const&... args)
+	{
+		if constexpr (Detail::IsStaticCompiledFormat<Format>)
+		{
+			static_assert(
+			    Detail::CheckStaticCompiledFormat<Core::Misc::RemoveCvRef<StringConverter>, Format,
+			                                      Args...>());
+		}
+
+		auto result = FormatErrorCode::Success;
+		Detail::WithOutputSink<Format::UsingCodePage>(output, [&](auto& sink) {
+			const auto argsTuple = std::forward_as_tuple(args...);
+			for (auto const& segment : format.GetSegments())
+			{
+				if (segment.ArgumentInfo.has_value())
+				{
+					const auto& info = *segment.ArgumentInfo;
+					if (!Core::Misc::RuntimeGet(info.Index, argsTuple, [&](auto const& item) {
+						    result = Detail::ConvertArgument(
+						        std::forward<StringConverter>(stringConverter), item,
+						        segment.PreparedOption, sink);
+					    }))
+					{
+						result = Detail::GetFormatErrorPolicy<StringConverter>::OnFormatError(
+						    FormatErrorCode::IndexOutOfRange);
+					}
+
+					if (result != FormatErrorCode::Success)
+					{
+						return;
+					}
+				}
+				else
+				{
+					sink.Append(segment.LiteralText.GetSpan());
+				}
+			}
+		});
+		return result;
+	}
+
+	template <typename OutputReceiver, Encoding::CodePage::CodePageType CodePageValue,
+	          std::size_t Extent, typename... Args>
+	constexpr void
+	FormatStringWithReceiver(OutputReceiver&& receiver,
+	                         Encoding::StringView<CodePageValue, Extent> const& format,
+	                         Args const&... args)
+	{
+		FormatStringWithCustomFormatter(std::forward<OutputReceiver>(receiver), DefaultFormatter{},
+		                                DefaultStringConverter{}, format, args...);
+	}
+
+	template <typename OutputReceiver, PreparedFormat Format, typename... Args>
+	constexpr void FormatStringWithReceiver(OutputReceiver&& receiver, Format const& format,
+	                                        Args const&... args)
+	{
+		FormatStringWithCustomConverter(std::forward<OutputReceiver>(receiver),
+		                                DefaultStringConverter{}, format, args...);
+	}
+
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	constexpr std::size_t
+	FormatStringSize(Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	{
+		CountingSink<CodePageValue> sink;
+		FormatStringWithReceiver(sink, format, args...);
+		return sink.GetSize();
+	}
+
+	template <PreparedFormat Format, typename... Args>
+	constexpr std::size_t FormatStringSize(Format const& format, Args const&... args)
+	{
+		// 长度提示准确时无需实际进行格式化
+		if (const auto sizeHint =
+		        Detail::GetFormatSizeHint(DefaultStringConverter{}, format, args...);
+		    sizeHint.IsExact)
+		{
+			return sizeHint.Size;
+		}
+
+		CountingSink<Format::UsingCodePage> sink;
+		FormatStringWithReceiver(sink, format, args...);
+		return sink.GetSize();
+	}
+
+	template <typename Allocator, std::size_t SsoThresholdSize, typename GrowPolicy,
+	          Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	Encoding::String<CodePageValue, Allocator, SsoThresholdSize, GrowPolicy>
+	FormatCustomString(Encoding::StringView<CodePageValue, Extent> const& format,
+	                   Args const&... args)
+	{
+		Encoding::String<CodePageValue, Allocator, SsoThresholdSize, GrowPolicy> resultStr;
+		resultStr.Reserve(
+		    Detail::EstimateFormatSize(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiver(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	Encoding::String<CodePageValue>
+	FormatString(Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	{
+		Encoding::String<CodePageValue> resultStr;
+		resultStr.Reserve(
+		    Detail::EstimateFormatSize(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiver(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	template <typename Allocator, std::size_t SsoThresholdSize, typename GrowPolicy,
+	          PreparedFormat Format, typename... Args>
+	Encoding::String<Format::UsingCodePage, Allocator, SsoThresholdSize, GrowPolicy>
+	FormatCustomString(Format const& format, Args const&... args)
+	{
+		Encoding::String<Format::UsingCodePage, Allocator, SsoThresholdSize, GrowPolicy> resultStr;
+		resultStr.Reserve(
+		    Detail::GetFormatSizeHint(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiver(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	template <PreparedFormat Format, typename... Args>
+	Encoding::String<Format::UsingCodePage> FormatString(Format const& format, Args const&... args)
+	{
+		Encoding::String<Format::UsingCodePage> resultStr;
+		resultStr.Reserve(
+		    Detail::GetFormatSizeHint(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiver(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	/// @brief  使用 allocator 分配结果的 FormatString，allocator 将被 rebind 到编码单元类型
+	/// @remark 与 ArenaAllocator 配合使用时，预估大小不足导致的重新分配所释放的内存将在 Arena 重置前一直占用
+	template <Detail::AllocatorType Allocator, Encoding::CodePage::CodePageType CodePageValue,
+	          std::size_t Extent, typename... Args>
+	Detail::StringWithAllocator<CodePageValue, Allocator>
+	FormatString(std::allocator_arg_t, Allocator const& allocator,
+	             Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	{
+		auto resultStr = Detail::MakeStringWithAllocator<CodePageValue>(allocator);
+		resultStr.Reserve(
+		    Detail::EstimateFormatSize(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiver(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	template <Detail::AllocatorType Allocator, PreparedFormat Format, typename... Args>
+	Detail::StringWithAllocator<Format::UsingCodePage, Allocator>
+	FormatString(std::allocator_arg_t, Allocator const& allocator, Format const& format,
+	             Args const&... args)
+	{
+		auto resultStr = Detail::MakeStringWithAllocator<Format::UsingCodePage>(allocator);
+		resultStr.Reserve(
+		    Detail::GetFormatSizeHint(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiver(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	/// @brief  将 FromCodePage 编码的结果转换到目标 OutputSink 的编码后写入的 OutputSink
+	/// @remark 可跨越多次写入的码点将暂存至下次写入，写入结束后应调用 Finish 检查是否有不完整的码点
+	///         两者均兼容 ASCII 时，ASCII 部分直接逐单元写入目标，数值等 ASCII 结果不经过中间缓冲区
+	///         非 ASCII 部分按段转换后写入目标，存在快速转换的内核时使用 Detail::TranscodeAppend
+	///         无法转换时抛出 EncodingFailedException
+	template <Encoding::CodePage::CodePageType FromCodePage, OutputSink Sink>
+	class TranscodingSink
+	    : public Detail::OutputSinkCallOperator<TranscodingSink<FromCodePage, Sink>, FromCodePage>
+	{
+	public:
+		static constexpr Encoding::CodePage::CodePageType UsingCodePage = FromCodePage;
+		static constexpr Encoding::CodePage::CodePageType TargetCodePage = Sink::UsingCodePage;
+		using CharType = typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType;
+
+		constexpr explicit TranscodingSink(Sink& target) noexcept : m_Target{ target }
+		{
+		}
+
+		constexpr std::span<CharType> Reserve(std::size_t size)
+		{
+			if constexpr (FromCodePage == TargetCodePage)
 			{
-				return { false, 0 };
+				return m_Target.Reserve(size);
+			}
+			else
+			{
+				return m_Buffer.Get(size);
 			}
-
-			using Trait = Encoding::CodePage::CodePageTrait<CodePageValue>;
-			std::pair<bool, std::size_t> result;
-			Trait::ToCodePoint(format.GetSpan(), [&](auto const& encodingResult) {
-				if constexpr (Encoding::GetEncodingResultCode<decltype(encodingResult)> ==
-				              Encoding::EncodingResultCode::Accept)
-				{
-					result = { encodingResult.Result == codePoint, encodingResult.AdvanceCount };
-				}
-				else
-				{
-					result = { false, 1 };
-				}
-			});
-
-			return result;
 		}
 
-		// TODO: 是否可针对非编译期的情况优化？例如使用 SIMD
-		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
-		static constexpr std::size_t SkipUntil(Encoding::StringView<CodePageValue, Extent> format,
-		                                       Encoding::CodePointType codePoint) noexcept
+		constexpr void Commit(std::size_t size)
 		{
-			if (format.IsEmpty())
+			if constexpr (FromCodePage == TargetCodePage)
 			{
-				return 0;
+				m_Target.Commit(size);
+			}
+			else
+			{
+				Append(m_Buffer.Committed(size));
 			}
+		}
 
-			using Trait = Encoding::CodePage::CodePageTrait<CodePageValue>;
-			std::size_t result{};
-			auto shouldStop = false;
-			do
+		constexpr void Append(std::span<const CharType> units)
+		{
+			if constexpr (FromCodePage == TargetCodePage)
 			{
-				Trait::ToCodePoint(format.GetSpan(), [&](auto const& encodingResult) {
-					if constexpr (Encoding::GetEncodingResultCode<decltype(encodingResult)> ==
-					              Encoding::EncodingResultCode::Accept)
-					{
-						shouldStop = encodingResult.Result == codePoint;
-						// 到匹配之时即停止，不消费匹配的值
-						if (!shouldStop)
-						{
-							result += encodingResult.AdvanceCount;
-							format = format.SubStr(encodingResult.AdvanceCount);
-						}
-					}
-					else
+				m_Target.Append(units);
+			}
+			else
+			{
+				if (m_PendingSize)
+				{
+					// 补全上次未完整的码点，之后的部分从 units 中继续
+					const auto fillSize = std::min(units.size(), m_Pending.size() - m_PendingSize);
+					std::copy_n(units.begin(), fillSize, m_Pending.begin() + m_PendingSize);
+					const auto consumed = Transcode(
+					    std::span<const CharType>(m_Pending.data(), m_PendingSize + fillSize));
+					if (!consumed)
 					{
-						// 编码失败，此时不与要寻找的值匹配因此增加并继续
-						++result;
-						format = format.SubStr(1);
+						m_PendingSize += fillSize;
+						return;
 					}
-				});
-			} while (!shouldStop && !format.IsEmpty());
-			return result;
+
+					units = units.subspan(consumed - m_PendingSize);
+					m_PendingSize = 0;
+				}
+
+				const auto rest = units.subspan(Transcode(units));
+				std::copy(rest.begin(), rest.end(), m_Pending.begin());
+				m_PendingSize = rest.size();
+			}
 		}
 
-		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
-		constexpr std::pair<FormatInfo<CodePageValue>, std::size_t>
-		ParseFormatInfo(Encoding::StringView<CodePageValue, Extent> const& format)
+		constexpr void AppendAscii(std::span<const char> chars)
 		{
-			Encoding::StringView<CodePageValue> formatStr = format;
-			const auto begin = formatStr.begin();
-			FormatInfo<CodePageValue> result{};
+			Detail::EmitAscii<TargetCodePage>(chars, m_Target);
+		}
 
-			const auto beginWithFormatLeftQuote = BeginWith(formatStr, FormatLeftQuote);
-			if (!beginWithFormatLeftQuote.first)
+		/// @brief  结束写入，存在不完整的码点时抛出 EncodingFailedException
+		constexpr void Finish()
+		{
+			if (m_PendingSize)
 			{
-				CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid format string."));
+				m_PendingSize = 0;
+				CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Incomplete code point."));
 			}
+		}
 
-			formatStr = formatStr.SubStr(beginWithFormatLeftQuote.second);
+	private:
+		Sink& m_Target;
+		Detail::SinkStagingBuffer<FromCodePage> m_Buffer;
+		std::array<CharType, Encoding::CodePage::GetMaxWidth<FromCodePage>()> m_Pending{};
+		std::size_t m_PendingSize{};
 
-			auto indexBegin = formatStr.begin();
-			while (true)
-			{
-				if (formatStr.IsEmpty())
-				{
-					CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid format string."));
-				}
+		/// @brief  转换 units 中的完整码点，返回转换的编码单元数量，末尾不完整的码点不转换
+		constexpr std::size_t Transcode(std::span<const CharType> units)
+		{
+			using TargetCharType =
+			    typename Encoding::CodePage::CodePageTrait<TargetCodePage>::CharType;
 
-				const auto prevPos = formatStr.begin();
-				const auto beginWithFormatOptionToken = BeginWith(formatStr, FormatOptionToken);
-				auto parseFormatOption = true;
-				if (beginWithFormatOptionToken.first)
-				{
-					formatStr = formatStr.SubStr(beginWithFormatOptionToken.second);
-				}
-				else
-				{
-					const auto beginWithFormatRightQuote = BeginWith(formatStr, FormatRightQuote);
-					formatStr = formatStr.SubStr(beginWithFormatRightQuote.second);
-					if (beginWithFormatRightQuote.first)
-					{
-						parseFormatOption = false;
-					}
-					else
+			if constexpr (Detail::HasFastTranscoder<FromCodePage, TargetCodePage>)
+			{
+				// 快速转换的内核自行处理 ASCII 部分，并分块写入目标
+				return Detail::TranscodeAppend<TargetCodePage, FromCodePage>(
+				    units, m_Target, ReplacementRule::PerCodeUnit, false,
+				    [](std::size_t, std::size_t) {
+					    CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Encoding failed."));
+				    });
+			}
+			else
+			{
+				// 非 ASCII 部分先转换到栈上缓冲区，缓冲区满或该段结束时才写入目标
+				std::array<TargetCharType, 256> buffer;
+				std::size_t bufferSize{};
+				const auto flush = [&] {
+					if (bufferSize)
 					{
-						continue;
+						m_Target.Append(std::span<const TargetCharType>(buffer.data(), bufferSize));
+						bufferSize = 0;
 					}
-				}
+				};
 
-				if (indexBegin == prevPos)
-				{
-					if (m_CurrentMode == Mode::IndexMode)
+				std::size_t consumed{};
+				auto isIncomplete = false;
+				const auto append = [&](auto const& result) {
+					constexpr auto resultCode = Encoding::GetEncodingResultCode<decltype(result)>;
+					if constexpr (resultCode == Encoding::EncodingResultCode::Accept)
 					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid format string."));
-					}
+						using ResultType = Core::Misc::RemoveCvRef<decltype(result.Result)>;
+						consumed += result.AdvanceCount;
+						if (bufferSize + Encoding::CodePage::GetMaxWidth<TargetCodePage>() >
+						    buffer.size())
+						{
+							flush();
+						}
 
-					m_CurrentMode = Mode::AutoMode;
-				}
-				else
-				{
-					if (m_CurrentMode == Mode::AutoMode)
+						if constexpr (std::is_same_v<ResultType, TargetCharType>)
+						{
+							buffer[bufferSize++] = result.Result;
+						}
+						else
+						{
+							const std::span<const TargetCharType> encoded(result.Result);
+							std::copy(encoded.begin(), encoded.end(), buffer.begin() + bufferSize);
+							bufferSize += encoded.size();
+						}
+					}
+					else if constexpr (resultCode == Encoding::EncodingResultCode::Incomplete)
 					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid format string."));
+						isIncomplete = true;
 					}
-
-					m_CurrentMode = Mode::IndexMode;
-				}
-
-				if (m_CurrentMode == Mode::IndexMode)
-				{
-					const auto parsedIndex =
-					    AsciiToNumber(Encoding::StringView<CodePageValue, Extent>{
-					        std::span(indexBegin, prevPos) });
-
-					if (parsedIndex.second != std::distance(indexBegin, prevPos))
+					else
 					{
-						CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid format string."));
+						flush();
+						CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Encoding failed."));
 					}
+				};
 
-					result.Index = parsedIndex.first;
-				}
-				else
-				{
-					assert(m_CurrentMode == Mode::AutoMode);
-					result.Index = m_CurrentIndex++;
-				}
-
-				if (parseFormatOption)
+				while (consumed < units.size())
 				{
-					const auto formatOptionBegin = formatStr.begin();
-					while (true)
+					auto end = consumed;
+					if constexpr (IsAsciiCompatible<FromCodePage> &&
+					              IsAsciiCompatible<TargetCodePage>)
 					{
-						if (formatStr.IsEmpty())
+						while (end < units.size() && static_cast<std::uint32_t>(units[end]) < 0x80)
 						{
-							CAFE_THROW(FormatException, CAFE_UTF8_SV("Invalid format string."));
+							++end;
 						}
 
-						const auto beginWithFormatRightQuote =
-						    BeginWith(formatStr, FormatRightQuote);
-						const auto curPos = formatStr.begin();
-						formatStr = formatStr.SubStr(beginWithFormatRightQuote.second);
-						if (beginWithFormatRightQuote.first)
+						if (end != consumed)
 						{
-							result.FormatOptionText = Encoding::StringView<CodePageValue, Extent>{
-								std::span(formatOptionBegin, curPos)
-							};
-							break;
+							const auto size = end - consumed;
+							const auto target = m_Target.Reserve(size);
+							for (std::size_t i = 0; i < size; ++i)
+							{
+								target[i] = static_cast<TargetCharType>(units[consumed + i]);
+							}
+							m_Target.Commit(size);
+							consumed = end;
+						}
+
+						while (end < units.size() && static_cast<std::uint32_t>(units[end]) >= 0x80)
+						{
+							++end;
 						}
 					}
+					else
+					{
+						end = units.size();
+					}
+
+					isIncomplete = false;
+					Encoding::Encoder<FromCodePage, TargetCodePage>::EncodeAll(
+					    units.subspan(consumed, end - consumed), append);
+					flush();
+
+					if (isIncomplete)
+					{
+						break;
+					}
 				}
 
-				break;
+				return consumed;
 			}
-
-			return { result, std::distance(begin, formatStr.begin()) };
 		}
+	};
 
-	public:
-		/// @brief  尝试分析格式化信息
-		/// @return 格式化信息、消耗的编码单元个数、跳过的编码单元个数
-		///         跳过的编码单元不计入消耗之中，将会直接跳过，为了处理 escape
-		template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
-		constexpr std::tuple<std::optional<FormatInfo<CodePageValue>>, std::size_t, std::size_t>
-		TryParseFormatInfo(Encoding::StringView<CodePageValue, Extent> const& format)
+	/// @brief  格式化 format 并将结果转换到 ToCodePage 编码后写入 output，不生成中间字符串
+	/// @param  output  ToCodePage 编码的 OutputSink，或以 span 为参数的接收器
+	template <Encoding::CodePage::CodePageType ToCodePage, typename Output,
+	          Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	void FormatStringWithReceiverAs(Output&& output,
+	                                Encoding::StringView<CodePageValue, Extent> const& format,
+	                                Args const&... args)
+	{
+		Detail::WithOutputSink<ToCodePage>(output, [&](auto& sink) {
+			TranscodingSink<CodePageValue, Core::Misc::RemoveCvRef<decltype(sink)>> transcodingSink{
+				sink
+			};
+			FormatStringWithReceiver(transcodingSink, format, args...);
+			transcodingSink.Finish();
+		});
+	}
+
+	template <Encoding::CodePage::CodePageType ToCodePage, typename Output, PreparedFormat Format,
+	          typename... Args>
+	void FormatStringWithReceiverAs(Output&& output, Format const& format, Args const&... args)
+	{
+		Detail::WithOutputSink<ToCodePage>(output, [&](auto& sink) {
+			TranscodingSink<Format::UsingCodePage, Core::Misc::RemoveCvRef<decltype(sink)>>
+			    transcodingSink{ sink };
+			FormatStringWithReceiver(transcodingSink, format, args...);
+			transcodingSink.Finish();
+		});
+	}
+
+	/// @brief  格式化 format 并返回转换到 ToCodePage 编码的结果，等价于 EncodeTo<ToCodePage>(FormatString(...))
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	Encoding::String<ToCodePage>
+	FormatStringAs(Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	{
+		Encoding::String<ToCodePage> resultStr;
+		// 源编码的长度通常不小于转换到 UTF-16 或 UTF-32 后的长度
+		resultStr.Reserve(
+		    Detail::EstimateFormatSize(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiverAs<ToCodePage>(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	template <Encoding::CodePage::CodePageType ToCodePage, PreparedFormat Format, typename... Args>
+	Encoding::String<ToCodePage> FormatStringAs(Format const& format, Args const&... args)
+	{
+		Encoding::String<ToCodePage> resultStr;
+		resultStr.Reserve(
+		    Detail::GetFormatSizeHint(DefaultStringConverter{}, format, args...).Size);
+		FormatStringWithReceiverAs<ToCodePage>(StringSink{ resultStr }, format, args...);
+		return resultStr;
+	}
+
+	struct FormatToResult
+	{
+		/// @brief  写入缓冲区的编码单元数量
+		std::size_t WrittenSize;
+		/// @brief  完整写入结果所需的编码单元数量，大于 WrittenSize 时表示结果被截断
+		std::size_t RequiredSize;
+
+		constexpr bool IsTruncated() const noexcept
 		{
-			const auto beginWithFormatPrefix = BeginWith(format, FormatPrefix);
-			if (!beginWithFormatPrefix.first)
-			{
-				const auto skippedLength =
-				    SkipUntil(format.SubStr(beginWithFormatPrefix.second), FormatPrefix);
-				return { {}, beginWithFormatPrefix.second + skippedLength, 0 };
-			}
+			return WrittenSize < RequiredSize;
+		}
+	};
 
-			const auto restFormat = format.SubStr(beginWithFormatPrefix.second);
-			const auto [secondIsFormatPrefix, consumedCount] = BeginWith(restFormat, FormatPrefix);
-			// 下一个仍然是 FormatPrefix，作为 escape 被跳过
-			if (secondIsFormatPrefix)
-			{
-				return { {}, consumedCount, beginWithFormatPrefix.second };
-			}
+	/// @brief  将格式化结果写入 buffer，不分配内存
+	/// @remark 空间不足时在码点边界处截断，不写入结尾的空字符
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	constexpr FormatToResult
+	FormatTo(std::span<typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType> buffer,
+	         Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	{
+		SpanSink<CodePageValue> sink{ buffer };
+		FormatStringWithReceiver(sink, format, args...);
+		return { sink.GetWrittenSize(), sink.GetRequiredSize() };
+	}
 
-			auto result = ParseFormatInfo(restFormat);
-			return { std::move(result.first), beginWithFormatPrefix.second + result.second, 0 };
+	template <PreparedFormat Format, typename... Args>
+	constexpr FormatToResult
+	FormatTo(std::span<typename Encoding::CodePage::CodePageTrait<Format::UsingCodePage>::CharType>
+	             buffer,
+	         Format const& format, Args const&... args)
+	{
+		SpanSink<Format::UsingCodePage> sink{ buffer };
+		FormatStringWithReceiver(sink, format, args...);
+		return { sink.GetWrittenSize(), sink.GetRequiredSize() };
+	}
+
+	/// @brief  将格式化结果写入 buffer 开始的至多 size 个编码单元
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	constexpr FormatToResult
+	FormatToN(typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType* buffer,
+	          std::size_t size, Encoding::StringView<CodePageValue, Extent> const& format,
+	          Args const&... args)
+	{
+		return FormatTo(std::span(buffer, size), format, args...);
+	}
+
+	template <PreparedFormat Format, typename... Args>
+	constexpr FormatToResult
+	FormatToN(typename Encoding::CodePage::CodePageTrait<Format::UsingCodePage>::CharType* buffer,
+	          std::size_t size, Format const& format, Args const&... args)
+	{
+		return FormatTo(std::span(buffer, size), format, args...);
+	}
+
+	/// @brief  可能失败的格式化的结果
+	template <typename T>
+	struct FormatResult
+	{
+		FormatErrorCode ErrorCode;
+		/// @brief  出错时为已写出的部分结果
+		T Result;
+
+		constexpr explicit operator bool() const noexcept
+		{
+			return ErrorCode == FormatErrorCode::Success;
 		}
 	};
 
-	template <typename OutputReceiver, typename Formatter, typename StringConverter,
+	/// @brief  不抛出异常的 FormatStringWithReceiver，出错时停止格式化并返回错误码，已写出的结果不会被撤销
+	/// @remark ErrorPolicy 可为 ReturnFormatErrorPolicy 或 AssumeValidFormatPolicy，
+	///         编译期分析的格式串仍然在编译期检查
+	///         receiver 及 FormatValue 抛出的异常将导致 std::terminate
+	template <typename ErrorPolicy = ReturnFormatErrorPolicy, typename OutputReceiver,
 	          Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
-	constexpr void FormatStringWithCustomFormatter(
-	    OutputReceiver&& receiver, Formatter&& formatter, StringConverter&& stringConverter,
-	    Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	requires NoexceptFormatErrorPolicy<ErrorPolicy>
+	constexpr FormatErrorCode
+	TryFormatStringWithReceiver(OutputReceiver&& receiver,
+	                            Encoding::StringView<CodePageValue, Extent> const& format,
+	                            Args const&... args) noexcept
 	{
-		Encoding::StringView<CodePageValue> formatStr = format;
-		const auto argsTuple = std::forward_as_tuple(args...);
-		while (true)
-		{
-			const auto [formatInfo, advanceCount, skippedCount] =
-			    std::forward<Formatter>(formatter).TryParseFormatInfo(formatStr);
-			formatStr = formatStr.SubStr(skippedCount);
-			const auto prevPos = formatStr.begin();
-			formatStr = formatStr.SubStr(advanceCount);
-			if (formatInfo.has_value())
-			{
-				const auto info = formatInfo.value();
-				if (!Core::Misc::RuntimeGet(info.Index, argsTuple, [&](auto const& item) {
-					    std::forward<StringConverter>(stringConverter)
-					        .ToString(item, info.FormatOptionText, [&](auto&& str) {
-						        std::forward<OutputReceiver>(receiver)(
-						            static_cast<decltype(str)&&>(str));
-					        });
-				    }))
-				{
-					CAFE_THROW(FormatException, CAFE_UTF8_SV("Index out of range."));
-				}
-			}
-			else if (prevPos != formatStr.end())
-			{
-				std::forward<OutputReceiver>(receiver)(
-				    Encoding::StringView<CodePageValue>{ std::span(prevPos, formatStr.begin()) });
-			}
-			else
-			{
-				break;
-			}
-		}
+		return FormatStringWithCustomFormatter(
+		    std::forward<OutputReceiver>(receiver), BasicDefaultFormatter<ErrorPolicy>{},
+		    BasicDefaultStringConverter<ErrorPolicy>{}, format, args...);
 	}
 
-	template <typename OutputReceiver, Encoding::CodePage::CodePageType CodePageValue,
-	          std::size_t Extent, typename... Args>
-	constexpr void
-	FormatStringWithReceiver(OutputReceiver&& receiver,
-	                         Encoding::StringView<CodePageValue, Extent> const& format,
-	                         Args const&... args)
+	template <typename ErrorPolicy = ReturnFormatErrorPolicy, typename OutputReceiver,
+	          PreparedFormat Format, typename... Args>
+	requires NoexceptFormatErrorPolicy<ErrorPolicy>
+	constexpr FormatErrorCode TryFormatStringWithReceiver(OutputReceiver&& receiver,
+	                                                      Format const& format,
+	                                                      Args const&... args) noexcept
 	{
-		FormatStringWithCustomFormatter(std::forward<OutputReceiver>(receiver), DefaultFormatter{},
-		                                DefaultStringConverter{}, format, args...);
+		return FormatStringWithCustomConverter(std::forward<OutputReceiver>(receiver),
+		                                       BasicDefaultStringConverter<ErrorPolicy>{}, format,
+		                                       args...);
 	}
 
-	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
-	constexpr std::size_t
-	FormatStringSize(Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	/// @brief  不抛出异常的 FormatString
+	/// @remark 分配内存失败时将导致 std::terminate
+	template <typename ErrorPolicy = ReturnFormatErrorPolicy,
+	          Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
+	requires NoexceptFormatErrorPolicy<ErrorPolicy>
+	FormatResult<Encoding::String<CodePageValue>>
+	TryFormatString(Encoding::StringView<CodePageValue, Extent> const& format,
+	                Args const&... args) noexcept
 	{
-		std::size_t size{};
-		FormatStringWithReceiver(
-		    [&](auto const& result) {
-			    using ResultType = Core::Misc::RemoveCvRef<decltype(result)>;
-			    if constexpr (std::is_same_v<ResultType, typename Encoding::CodePage::CodePageTrait<
-			                                                 CodePageValue>::CharType>)
-			    {
-				    ++size;
-			    }
-			    else
-			    {
-				    size += result.GetSize();
-			    }
-		    },
-		    format, args...);
-		return size;
+		FormatResult<Encoding::String<CodePageValue>> result{};
+		result.Result.Reserve(
+		    Detail::EstimateFormatSize(BasicDefaultStringConverter<ErrorPolicy>{}, format, args...)
+		        .Size);
+		result.ErrorCode =
+		    TryFormatStringWithReceiver<ErrorPolicy>(StringSink{ result.Result }, format, args...);
+		return result;
 	}
 
-	template <typename Allocator, std::size_t SsoThresholdSize, typename GrowPolicy,
+	template <typename ErrorPolicy = ReturnFormatErrorPolicy, PreparedFormat Format,
+	          typename... Args>
+	requires NoexceptFormatErrorPolicy<ErrorPolicy>
+	FormatResult<Encoding::String<Format::UsingCodePage>>
+	TryFormatString(Format const& format, Args const&... args) noexcept
+	{
+		FormatResult<Encoding::String<Format::UsingCodePage>> result{};
+		result.Result.Reserve(
+		    Detail::GetFormatSizeHint(BasicDefaultStringConverter<ErrorPolicy>{}, format, args...)
+		        .Size);
+		result.ErrorCode =
+		    TryFormatStringWithReceiver<ErrorPolicy>(StringSink{ result.Result }, format, args...);
+		return result;
+	}
+
+	/// @brief  不抛出异常的 FormatTo
+	template <typename ErrorPolicy = ReturnFormatErrorPolicy,
 	          Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
-	Encoding::String<CodePageValue, Allocator, SsoThresholdSize, GrowPolicy>
-	FormatCustomString(Encoding::StringView<CodePageValue, Extent> const& format,
-	                   Args const&... args)
+	requires NoexceptFormatErrorPolicy<ErrorPolicy>
+	constexpr FormatResult<FormatToResult>
+	TryFormatTo(std::span<typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType> buffer,
+	            Encoding::StringView<CodePageValue, Extent> const& format,
+	            Args const&... args) noexcept
 	{
-		Encoding::String<CodePageValue, Allocator, SsoThresholdSize, GrowPolicy> resultStr;
-		FormatStringWithReceiver([&](auto const& result) { resultStr.Append(result); }, format,
-		                         args...);
-		return resultStr;
+		SpanSink<CodePageValue> sink{ buffer };
+		const auto errorCode = TryFormatStringWithReceiver<ErrorPolicy>(sink, format, args...);
+		return { errorCode, { sink.GetWrittenSize(), sink.GetRequiredSize() } };
 	}
 
-	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent, typename... Args>
-	Encoding::String<CodePageValue>
-	FormatString(Encoding::StringView<CodePageValue, Extent> const& format, Args const&... args)
+	template <typename ErrorPolicy = ReturnFormatErrorPolicy, PreparedFormat Format,
+	          typename... Args>
+	requires NoexceptFormatErrorPolicy<ErrorPolicy>
+	constexpr FormatResult<FormatToResult>
+	TryFormatTo(std::span<typename Encoding::CodePage::CodePageTrait<Format::UsingCodePage>::CharType>
+	                buffer,
+	            Format const& format, Args const&... args) noexcept
 	{
-		Encoding::String<CodePageValue> resultStr;
-		FormatStringWithReceiver([&](auto const& result) { resultStr.Append(result); }, format,
-		                         args...);
-		return resultStr;
+		SpanSink<Format::UsingCodePage> sink{ buffer };
+		const auto errorCode = TryFormatStringWithReceiver<ErrorPolicy>(sink, format, args...);
+		return { errorCode, { sink.GetWrittenSize(), sink.GetRequiredSize() } };
 	}
 } // namespace Cafe::TextUtils
@@ -0,0 +1,410 @@
+#pragma once
+
+#include <Cafe/TextUtils/Format.h>
+
+namespace Cafe::TextUtils
+{
+	/// @brief  类型擦除的 OutputSink 引用，使格式化引擎对每种编码只实例化一次
+	/// @remark 本类仅引用被包装的 sink，必须由用户保证其生命期
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	class AnySink : public Detail::OutputSinkCallOperator<AnySink<CodePageValue>, CodePageValue>
+	{
+	public:
+		static constexpr Encoding::CodePage::CodePageType UsingCodePage = CodePageValue;
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+		template <OutputSink Sink>
+		requires(!std::is_same_v<Sink, AnySink>) explicit AnySink(Sink& sink) noexcept
+		    : m_Sink{ &sink }, m_VTable{ &VTableOf<Sink> }
+		{
+			static_assert(Sink::UsingCodePage == CodePageValue,
+			              "Code page of the sink does not match.");
+		}
+
+		std::span<CharType> Reserve(std::size_t size)
+		{
+			return m_VTable->Reserve(m_Sink, size);
+		}
+
+		void Commit(std::size_t size)
+		{
+			m_VTable->Commit(m_Sink, size);
+		}
+
+		void Append(std::span<const CharType> units)
+		{
+			m_VTable->Append(m_Sink, units);
+		}
+
+	private:
+		struct VTable
+		{
+			std::span<CharType> (*Reserve)(void* sink, std::size_t size);
+			void (*Commit)(void* sink, std::size_t size);
+			void (*Append)(void* sink, std::span<const CharType> units);
+		};
+
+		template <typename Sink>
+		static constexpr VTable VTableOf{
+			[](void* sink, std::size_t size) { return static_cast<Sink*>(sink)->Reserve(size); },
+			[](void* sink, std::size_t size) { static_cast<Sink*>(sink)->Commit(size); },
+			[](void* sink, std::span<const CharType> units) {
+			    static_cast<Sink*>(sink)->Append(units);
+			}
+		};
+
+		void* m_Sink;
+		const VTable* m_VTable;
+	};
+
+	/// @brief  类型擦除的格式化参数，整数及浮点数按值保存，其余按引用保存
+	/// @remark 按引用保存的参数必须由用户保证其生命期，通常仅在调用格式化函数的表达式中构造
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	class FormatArgument
+	{
+	public:
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+		enum class ArgumentType : std::uint8_t
+		{
+			Signed,
+			Unsigned,
+			Float,
+			Double,
+			LongDouble,
+			String,
+			Custom,
+		};
+
+		template <typename T>
+		requires Formattable<T, CodePageValue>
+		constexpr explicit FormatArgument(T const& value) noexcept
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				// 整数的格式化结果仅与符号及绝对值有关，可以统一为最宽的类型
+				if constexpr (std::is_signed_v<T>)
+				{
+					m_Type = ArgumentType::Signed;
+					m_Signed = value;
+				}
+				else
+				{
+					m_Type = ArgumentType::Unsigned;
+					m_Unsigned = value;
+				}
+			}
+			else if constexpr (std::is_same_v<T, float>)
+			{
+				// 最短表示与类型有关，不能转换到 double
+				m_Type = ArgumentType::Float;
+				m_Float = value;
+			}
+			else if constexpr (std::is_same_v<T, double>)
+			{
+				m_Type = ArgumentType::Double;
+				m_Double = value;
+			}
+			else if constexpr (std::is_same_v<T, long double>)
+			{
+				m_Type = ArgumentType::LongDouble;
+				m_LongDouble = value;
+			}
+			else if constexpr (Encoding::IsStringView<T> || Encoding::IsString<T> ||
+			                   Encoding::IsStaticString<T>)
+			{
+				std::span<const CharType> span;
+				if constexpr (Encoding::IsStringView<T>)
+				{
+					span = value.GetTrimmedSpan();
+				}
+				else if constexpr (Encoding::IsStaticString<T>)
+				{
+					span = value.GetSpan();
+				}
+				else
+				{
+					span = value.GetView().GetTrimmedSpan();
+				}
+				m_Type = ArgumentType::String;
+				m_String = { span.data(), span.size() };
+			}
+			else
+			{
+				m_Type = ArgumentType::Custom;
+				m_Custom = { &value, [](const void* value,
+				                        Encoding::StringView<CodePageValue> const& formatOption,
+				                        AnySink<CodePageValue>& sink) {
+					            DefaultStringConverter::ToString(*static_cast<const T*>(value),
+					                                             formatOption, sink);
+				            } };
+			}
+		}
+
+		constexpr ArgumentType GetType() const noexcept
+		{
+			return m_Type;
+		}
+
+		/// @brief  使用 DefaultStringConverter 格式化本参数
+		void Format(Encoding::StringView<CodePageValue> const& formatOption,
+		            AnySink<CodePageValue>& sink) const
+		{
+			FormatValue(formatOption, sink);
+		}
+
+		/// @brief  以预先分析的格式化选项格式化本参数，自定义类型仍分析选项的文本
+		void Format(PreparedFormatOption<CodePageValue> const& formatOption,
+		            AnySink<CodePageValue>& sink) const
+		{
+			FormatValue(formatOption, sink);
+		}
+
+		/// @brief  以默认选项格式化时结果的长度提示，自定义类型不提供提示
+		FormatSizeHint GetSizeHint() const
+		{
+			const Encoding::StringView<CodePageValue> defaultOption;
+			switch (m_Type)
+			{
+			case ArgumentType::Signed:
+				return DefaultStringConverter::GetSizeHint(m_Signed, defaultOption);
+			case ArgumentType::Unsigned:
+				return DefaultStringConverter::GetSizeHint(m_Unsigned, defaultOption);
+			case ArgumentType::Float:
+				return DefaultStringConverter::GetSizeHint(m_Float, defaultOption);
+			case ArgumentType::Double:
+				return DefaultStringConverter::GetSizeHint(m_Double, defaultOption);
+			case ArgumentType::LongDouble:
+				return DefaultStringConverter::GetSizeHint(m_LongDouble, defaultOption);
+			case ArgumentType::String:
+				return { m_String.Size, true };
+			default:
+				return { 0, false };
+			}
+		}
+
+	private:
+		template <typename FormatOption>
+		void FormatValue(FormatOption const& formatOption, AnySink<CodePageValue>& sink) const
+		{
+			switch (m_Type)
+			{
+			case ArgumentType::Signed:
+				DefaultStringConverter::ToString(m_Signed, formatOption, sink);
+				break;
+			case ArgumentType::Unsigned:
+				DefaultStringConverter::ToString(m_Unsigned, formatOption, sink);
+				break;
+			case ArgumentType::Float:
+				DefaultStringConverter::ToString(m_Float, formatOption, sink);
+				break;
+			case ArgumentType::Double:
+				DefaultStringConverter::ToString(m_Double, formatOption, sink);
+				break;
+			case ArgumentType::LongDouble:
+				DefaultStringConverter::ToString(m_LongDouble, formatOption, sink);
+				break;
+			case ArgumentType::String:
+				sink.Append(std::span(m_String.Data, m_String.Size));
+				break;
+			case ArgumentType::Custom:
+				if constexpr (Detail::IsPreparedFormatOption<FormatOption>)
+				{
+					m_Custom.Format(m_Custom.Value, formatOption.Text, sink);
+				}
+				else
+				{
+					m_Custom.Format(m_Custom.Value, formatOption, sink);
+				}
+				break;
+			}
+		}
+
+		struct StringReference
+		{
+			const CharType* Data;
+			std::size_t Size;
+		};
+
+		struct CustomReference
+		{
+			const void* Value;
+			void (*Format)(const void* value,
+			               Encoding::StringView<CodePageValue> const& formatOption,
+			               AnySink<CodePageValue>& sink);
+		};
+
+		ArgumentType m_Type;
+		union
+		{
+			std::intmax_t m_Signed;
+			std::uintmax_t m_Unsigned;
+			float m_Float;
+			double m_Double;
+			long double m_LongDouble;
+			StringReference m_String;
+			CustomReference m_Custom;
+		};
+	};
+
+	/// @brief  保存参数的 FormatArgument 数组，由 MakeFormatArgs 创建
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t ArgumentCount>
+	struct FormatArgumentStore
+	{
+		std::array<FormatArgument<CodePageValue>, ArgumentCount> Arguments;
+	};
+
+	/// @brief  类型擦除的参数列表，引用 FormatArgumentStore 中的参数
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	class FormatArgs
+	{
+	public:
+		template <std::size_t ArgumentCount>
+		constexpr FormatArgs(
+		    FormatArgumentStore<CodePageValue, ArgumentCount> const& store) noexcept
+		    : m_Arguments{ store.Arguments }
+		{
+		}
+
+		constexpr std::size_t GetSize() const noexcept
+		{
+			return m_Arguments.size();
+		}
+
+		/// @brief  获得指定索引的参数，超出范围时抛出 FormatException
+		constexpr FormatArgument<CodePageValue> const& Get(std::size_t index) const
+		{
+			if (index >= m_Arguments.size())
+			{
+				CAFE_THROW(FormatException, CAFE_UTF8_SV("Index out of range."));
+			}
+
+			return m_Arguments[index];
+		}
+
+	private:
+		std::span<const FormatArgument<CodePageValue>> m_Arguments;
+	};
+
+	/// @brief  打包格式化参数，结果引用了 args 中的字符串及自定义类型，不应比 args 存活更久
+	template <Encoding::CodePage::CodePageType CodePageValue, typename... Args>
+	constexpr FormatArgumentStore<CodePageValue, sizeof...(Args)>
+	MakeFormatArgs(Args const&... args) noexcept
+	{
+		return { { FormatArgument<CodePageValue>(args)... } };
+	}
+
+	namespace Detail
+	{
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		void VFormatSegments(AnySink<CodePageValue>& sink,
+		                     std::span<const FormatSegment<CodePageValue>> segments,
+		                     FormatArgs<CodePageValue> args)
+		{
+			for (auto const& segment : segments)
+			{
+				if (segment.ArgumentInfo.has_value())
+				{
+					args.Get(segment.ArgumentInfo->Index).Format(segment.PreparedOption, sink);
+				}
+				else
+				{
+					sink.Append(segment.LiteralText.GetSpan());
+				}
+			}
+		}
+
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		void VFormatView(AnySink<CodePageValue>& sink, Encoding::StringView<CodePageValue> format,
+		                 FormatArgs<CodePageValue> args)
+		{
+			DefaultFormatter formatter;
+			while (true)
+			{
+				const auto [formatInfo, advanceCount, skippedCount] =
+				    formatter.TryParseFormatInfo(format);
+				format = format.SubStr(skippedCount);
+				const auto prevPos = format.begin();
+				format = format.SubStr(advanceCount);
+				if (formatInfo.has_value())
+				{
+					args.Get(formatInfo->Index).Format(formatInfo->FormatOptionText, sink);
+				}
+				else if (prevPos != format.end())
+				{
+					sink.Append(
+					    Encoding::StringView<CodePageValue>{ std::span(prevPos, format.begin()) }
+					        .GetTrimmedSpan());
+				}
+				else
+				{
+					break;
+				}
+			}
+		}
+
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		FormatSizeHint EstimateVFormatSize(std::size_t literalSize, FormatArgs<CodePageValue> args)
+		{
+			FormatSizeHint result{ literalSize, false };
+			for (std::size_t i = 0; i < args.GetSize(); ++i)
+			{
+				result += args.Get(i).GetSizeHint();
+			}
+			result.IsExact = false;
+			return result;
+		}
+	} // namespace Detail
+
+	/// @brief  使用类型擦除的参数格式化，格式化引擎对每种编码只实例化一次
+	/// @remark 仅支持 DefaultFormatter 及 DefaultStringConverter，
+	///         与 FormatStringWithReceiver 相比，调用处仅需实例化参数的打包
+	/// @param  output  OutputSink，或以 span 为参数的接收器
+	template <typename Output, Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+	void VFormatTo(Output&& output, Encoding::StringView<CodePageValue, Extent> const& format,
+	               std::type_identity_t<FormatArgs<CodePageValue>> args)
+	{
+		Detail::WithOutputSink<CodePageValue>(output, [&](auto& sink) {
+			AnySink<CodePageValue> anySink{ sink };
+			Detail::VFormatView<CodePageValue>(anySink, format, args);
+		});
+	}
+
+	template <typename Output, PreparedFormat Format>
+	void VFormatTo(Output&& output, Format const& format,
+	               std::type_identity_t<FormatArgs<Format::UsingCodePage>> args)
+	{
+		Detail::WithOutputSink<Format::UsingCodePage>(output, [&](auto& sink) {
+			AnySink<Format::UsingCodePage> anySink{ sink };
+			Detail::VFormatSegments<Format::UsingCodePage>(anySink, format.GetSegments(), args);
+		});
+	}
+
+	template <Encoding::CodePage::CodePageType CodePageValue, std::size_t Extent>
+	Encoding::String<CodePageValue>
+	VFormatString(Encoding::StringView<CodePageValue, Extent> const& format,
+	              std::type_identity_t<FormatArgs<CodePageValue>> args)
+	{
+		Encoding::String<CodePageValue> resultStr;
+		resultStr.Reserve(Detail::EstimateVFormatSize(format.GetSize(), args).Size);
+		VFormatTo(StringSink{ resultStr }, format, args);
+		return resultStr;
+	}
+
+	template <PreparedFormat Format>
+	Encoding::String<Format::UsingCodePage>
+	VFormatString(Format const& format,
+	              std::type_identity_t<FormatArgs<Format::UsingCodePage>> args)
+	{
+		std::size_t literalSize{};
+		for (auto const& segment : format.GetSegments())
+		{
+			literalSize += segment.LiteralText.GetSize();
+		}
+
+		Encoding::String<Format::UsingCodePage> resultStr;
+		resultStr.Reserve(Detail::EstimateVFormatSize(literalSize, args).Size);
+		VFormatTo(StringSink{ resultStr }, format, args);
+		return resultStr;
+	}
+} // namespace Cafe::TextUtils
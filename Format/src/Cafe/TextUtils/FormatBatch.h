@@ -0,0 +1,183 @@
+#pragma once
+
+#include <Cafe/TextUtils/Format.h>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <ranges>
+#include <thread>
+
+namespace Cafe::TextUtils
+{
+	struct FormatBatchOption
+	{
+		/// @brief  工作线程数，为 0 时使用 std::thread::hardware_concurrency()
+		std::size_t ThreadCount = 0;
+		/// @brief  每块包含的行数，每块由一个工作线程格式化到独立的缓冲区中
+		std::size_t ChunkSize = 1024;
+	};
+
+	namespace Detail
+	{
+		template <OutputSink Sink, PreparedFormat Format, typename Row>
+		void FormatBatchRow(Sink& sink, Format const& format, Row const& row)
+		{
+			std::apply(
+			    [&](auto const&... args) { FormatStringWithReceiver(sink, format, args...); }, row);
+		}
+
+		template <OutputSink Sink, PreparedFormat Format, std::ranges::random_access_range Rows>
+		void FormatBatchParallel(Sink& sink, Format const& format, Rows const& rows,
+		                         std::size_t chunkSize, std::size_t chunkCount,
+		                         std::size_t threadCount)
+		{
+			struct Chunk
+			{
+				Encoding::String<Format::UsingCodePage> Result;
+				std::exception_ptr Exception;
+				bool IsReady{};
+			};
+
+			const auto rowCount = static_cast<std::size_t>(std::ranges::size(rows));
+			// 限制尚未写出的块的数量，避免工作线程远远领先于写出而占用过多内存
+			const auto maxPendingChunks = threadCount * 2;
+
+			std::vector<Chunk> chunks(chunkCount);
+			std::mutex mutex;
+			std::condition_variable stateChanged;
+			std::size_t nextChunk{};
+			std::size_t writtenChunks{};
+			auto isStopped = false;
+
+			const auto worker = [&] {
+				while (true)
+				{
+					std::size_t index;
+					{
+						std::unique_lock lock{ mutex };
+						stateChanged.wait(lock, [&] {
+							return isStopped || nextChunk >= chunkCount ||
+							       nextChunk < writtenChunks + maxPendingChunks;
+						});
+						if (isStopped || nextChunk >= chunkCount)
+						{
+							return;
+						}
+						index = nextChunk++;
+					}
+
+					Encoding::String<Format::UsingCodePage> result;
+					std::exception_ptr exception;
+					try
+					{
+						StringSink resultSink{ result };
+						const auto end = std::min(rowCount, (index + 1) * chunkSize);
+						for (auto i = index * chunkSize; i < end; ++i)
+						{
+							FormatBatchRow(resultSink, format, std::ranges::begin(rows)[i]);
+						}
+					}
+					catch (...)
+					{
+						exception = std::current_exception();
+					}
+
+					{
+						std::lock_guard lock{ mutex };
+						chunks[index].Result = std::move(result);
+						chunks[index].Exception = std::move(exception);
+						chunks[index].IsReady = true;
+					}
+					stateChanged.notify_all();
+				}
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(threadCount);
+			const auto stopAndJoin = [&] {
+				{
+					std::lock_guard lock{ mutex };
+					isStopped = true;
+				}
+				stateChanged.notify_all();
+				for (auto& thread : workers)
+				{
+					thread.join();
+				}
+			};
+
+			try
+			{
+				for (std::size_t i = 0; i < threadCount; ++i)
+				{
+					workers.emplace_back(worker);
+				}
+
+				// 由调用线程按顺序写出
+				for (std::size_t i = 0; i < chunkCount; ++i)
+				{
+					Encoding::String<Format::UsingCodePage> result;
+					std::exception_ptr exception;
+					{
+						std::unique_lock lock{ mutex };
+						stateChanged.wait(lock, [&] { return chunks[i].IsReady; });
+						result = std::move(chunks[i].Result);
+						exception = std::move(chunks[i].Exception);
+						writtenChunks = i + 1;
+					}
+					stateChanged.notify_all();
+
+					if (exception)
+					{
+						std::rethrow_exception(exception);
+					}
+					sink.Append(result.GetView().GetTrimmedSpan());
+				}
+			}
+			catch (...)
+			{
+				stopAndJoin();
+				throw;
+			}
+
+			stopAndJoin();
+		}
+	} // namespace Detail
+
+	/// @brief  使用同一格式串并行格式化多行参数，结果按顺序写入 output
+	/// @remark rows 的每个元素为包含一行参数的类 tuple 对象，rows 按块分配给工作线程，
+	///         每块格式化到独立的缓冲区中，再由调用线程按顺序写出，结果与逐行调用 FormatStringWithReceiver 完全一致
+	///         format、rows 及参数的 FormatValue 会被多个线程同时访问
+	///         格式化时抛出的异常将在写出该块时由调用线程重新抛出，此前的块已写出
+	///         使用本函数需链接 Cafe.TextUtils.FormatBatch 以引入线程库
+	/// @param  output  OutputSink，或以 span 为参数的接收器，仅由调用线程访问
+	template <PreparedFormat Format, std::ranges::random_access_range Rows, typename Output>
+	requires std::ranges::sized_range<Rows>
+	void FormatBatch(Format const& format, Rows const& rows, Output&& output,
+	                 FormatBatchOption const& option = {})
+	{
+		Detail::WithOutputSink<Format::UsingCodePage>(output, [&](auto& sink) {
+			const auto rowCount = static_cast<std::size_t>(std::ranges::size(rows));
+			const auto chunkSize = std::max(option.ChunkSize, std::size_t{ 1 });
+			const auto chunkCount = (rowCount + chunkSize - 1) / chunkSize;
+			const auto threadCount = std::min(
+			    option.ThreadCount
+			        ? option.ThreadCount
+			        : std::max(static_cast<std::size_t>(std::thread::hardware_concurrency()),
+			                   std::size_t{ 1 }),
+			    chunkCount);
+
+			if (threadCount <= 1)
+			{
+				for (auto const& row : rows)
+				{
+					Detail::FormatBatchRow(sink, format, row);
+				}
+			}
+			else
+			{
+				Detail::FormatBatchParallel(sink, format, rows, chunkSize, chunkCount, threadCount);
+			}
+		});
+	}
+} // namespace Cafe::TextUtils
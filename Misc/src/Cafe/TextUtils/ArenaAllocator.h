@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace Cafe::TextUtils
+{
+	/// @brief  单调增长的内存区域，分配时仅移动指针，不单独释放，由 Reset 或析构一次性释放所有分配的内存
+	/// @remark 可使用用户提供的缓冲区作为最初的存储，用尽后再分配新的块，
+	///         本类不是线程安全的
+	class Arena
+	{
+	public:
+		static constexpr std::size_t DefaultChunkSize = 4096;
+
+		explicit Arena(std::size_t chunkSize = DefaultChunkSize) noexcept
+		    : Arena{ std::span<std::byte>{}, chunkSize }
+		{
+		}
+
+		/// @brief  以 initialBuffer 作为最初的存储，本类不取得其所有权
+		explicit Arena(std::span<std::byte> initialBuffer,
+		               std::size_t chunkSize = DefaultChunkSize) noexcept
+		    : m_InitialBuffer{ initialBuffer }, m_Current{ initialBuffer.data() },
+		      m_End{ initialBuffer.data() + initialBuffer.size() }, m_ChunkSize{ chunkSize }
+		{
+		}
+
+		Arena(Arena const&) = delete;
+		Arena& operator=(Arena const&) = delete;
+
+		/// @brief  分配 size 字节，对齐到 alignment，alignment 必须为 2 的幂
+		void* Allocate(std::size_t size, std::size_t alignment)
+		{
+			if (const auto result = TryAllocate(size, alignment))
+			{
+				return result;
+			}
+
+			// 保证新的块中对齐后仍有足够的空间
+			const auto chunkSize = std::max(m_ChunkSize, size + alignment);
+			auto& chunk = m_Chunks.emplace_back(std::make_unique<std::byte[]>(chunkSize));
+			m_Current = chunk.get();
+			m_End = m_Current + chunkSize;
+			return TryAllocate(size, alignment);
+		}
+
+		/// @brief  释放所有分配的内存，之前分配的所有内存均不再可用
+		void Reset() noexcept
+		{
+			m_Chunks.clear();
+			m_Current = m_InitialBuffer.data();
+			m_End = m_InitialBuffer.data() + m_InitialBuffer.size();
+		}
+
+		/// @brief  获得额外分配的块的数量，不包括用户提供的缓冲区
+		std::size_t GetChunkCount() const noexcept
+		{
+			return m_Chunks.size();
+		}
+
+	private:
+		std::span<std::byte> m_InitialBuffer;
+		std::byte* m_Current;
+		std::byte* m_End;
+		std::size_t m_ChunkSize;
+		std::vector<std::unique_ptr<std::byte[]>> m_Chunks;
+
+		void* TryAllocate(std::size_t size, std::size_t alignment) noexcept
+		{
+			const auto current = reinterpret_cast<std::uintptr_t>(m_Current);
+			const auto padding = (alignment - current % alignment) % alignment;
+			if (!m_Current || static_cast<std::size_t>(m_End - m_Current) < padding ||
+			    static_cast<std::size_t>(m_End - m_Current) - padding < size)
+			{
+				return nullptr;
+			}
+
+			const auto result = m_Current + padding;
+			m_Current = result + size;
+			return result;
+		}
+	};
+
+	/// @brief  从 Arena 分配内存的分配器，deallocate 不做任何事
+	/// @remark 可用于 Encoding::String 等容器，使用本分配器的对象必须在 Arena 重置或析构之前销毁
+	template <typename T>
+	class ArenaAllocator
+	{
+		template <typename U>
+		friend class ArenaAllocator;
+
+	public:
+		using value_type = T;
+
+		ArenaAllocator(Arena& arena) noexcept : m_Arena{ &arena }
+		{
+		}
+
+		template <typename U>
+		ArenaAllocator(ArenaAllocator<U> const& other) noexcept : m_Arena{ other.m_Arena }
+		{
+		}
+
+		T* allocate(std::size_t n)
+		{
+			if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+			{
+				throw std::bad_array_new_length{};
+			}
+
+			return static_cast<T*>(m_Arena->Allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, std::size_t) noexcept
+		{
+		}
+
+		Arena* GetArena() const noexcept
+		{
+			return m_Arena;
+		}
+
+		template <typename U>
+		bool operator==(ArenaAllocator<U> const& other) const noexcept
+		{
+			return m_Arena == other.m_Arena;
+		}
+
+	private:
+		Arena* m_Arena;
+	};
+} // namespace Cafe::TextUtils
@@ -0,0 +1,13 @@
+#pragma once
+
+// 可用的指令集，不可用时对应的宏未定义，应以 #if 检查
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CAFE_TEXTUTILS_HAS_SSE2 1
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CAFE_TEXTUTILS_HAS_AVX2 1
+#endif
@@ -2,6 +2,13 @@
 
 #include <Cafe/Encoding/Strings.h>
 #include <Cafe/ErrorHandling/ErrorHandling.h>
+#include <Cafe/TextUtils/UnicodeTranscode.h>
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 #if __has_include(<Cafe/Encoding/RuntimeEncoding.h>)
 #include <Cafe/Encoding/RuntimeEncoding.h>
@@ -12,6 +19,383 @@ namespace Cafe::TextUtils
 {
 	CAFE_DEFINE_GENERAL_EXCEPTION(EncodingFailedException);
 
+	/// @brief  编码是否与 ASCII 兼容
+	/// @remark 兼容指 ASCII 字符均编码为值与其相同的单个编码单元，且其他码点的编码中不会出现值小于 0x80 的编码单元，
+	///         此时可以不经解码直接按编码单元处理 ASCII 字符
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	constexpr bool IsAsciiCompatible =
+	    CodePageValue == Encoding::CodePage::Utf8 ||
+	    CodePageValue == Encoding::CodePage::CodePoint ||
+	    (std::endian::native == std::endian::little &&
+	     (CodePageValue == Encoding::CodePage::Utf16LittleEndian ||
+	      CodePageValue == Encoding::CodePage::Utf32LittleEndian)) ||
+	    (std::endian::native == std::endian::big &&
+	     (CodePageValue == Encoding::CodePage::Utf16BigEndian ||
+	      CodePageValue == Encoding::CodePage::Utf32BigEndian));
+
+	enum class ReplacementRule
+	{
+		// 每个无效的编码单元替换为一个替换字符
+		PerCodeUnit,
+		// 每个无效序列的最长子部分（maximal subpart）替换为一个替换字符，与 WHATWG Encoding 规范的 UTF-8 解码器一致
+		MaximalSubpart,
+	};
+
+	struct ReplacementOption
+	{
+		/// @brief  替换无效输入的码点，目标编码无法表示该码点时不写入任何内容
+		Encoding::CodePointType Replacement = 0xFFFD;
+		/// @brief  划分无效输入的规则，目前仅影响 UTF-8
+		ReplacementRule Rule = ReplacementRule::MaximalSubpart;
+	};
+
+	namespace Detail
+	{
+		template <typename T>
+		concept AllocatorType = requires(T& allocator)
+		{
+			typename T::value_type;
+			allocator.allocate(std::size_t{});
+		};
+
+		/// @brief  将 Allocator rebind 到 CodePageValue 的编码单元类型
+		template <Encoding::CodePage::CodePageType CodePageValue, typename Allocator>
+		using CharAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<
+		    typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType>;
+
+		template <Encoding::CodePage::CodePageType CodePageValue, typename Allocator>
+		using StringWithAllocator =
+		    Encoding::String<CodePageValue, CharAllocator<CodePageValue, Allocator>>;
+
+		template <Encoding::CodePage::CodePageType CodePageValue, typename Allocator>
+		StringWithAllocator<CodePageValue, Allocator>
+		MakeStringWithAllocator(Allocator const& allocator)
+		{
+			return StringWithAllocator<CodePageValue, Allocator>{
+				CharAllocator<CodePageValue, Allocator>(allocator)
+			};
+		}
+
+		/// @brief  获得 input 开头的无效序列按 rule 替换时的长度
+		template <Encoding::CodePage::CodePageType FromCodePage>
+		constexpr std::size_t GetInvalidSequenceLength(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    ReplacementRule rule) noexcept
+		{
+			if constexpr (FromCodePage == Encoding::CodePage::Utf8)
+			{
+				if (rule == ReplacementRule::MaximalSubpart)
+				{
+					return GetUtf8MaximalSubpartLength(input);
+				}
+			}
+
+			// 其他编码的无效序列均为单个编码单元
+			return 1;
+		}
+
+		/// @brief  将 codePoint 编码到 ToCodePage 并追加到 resultStr，无法编码时不追加任何内容
+		template <Encoding::CodePage::CodePageType ToCodePage, typename StringType>
+		void AppendCodePoint(Encoding::CodePointType codePoint, StringType& resultStr)
+		{
+			Encoding::CodePage::CodePageTrait<ToCodePage>::FromCodePoint(
+			    codePoint, [&](auto const& result) {
+				    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
+				                  Encoding::EncodingResultCode::Accept)
+				    {
+					    resultStr.Append(result.Result);
+				    }
+			    });
+		}
+
+		/// @brief  单遍转换 input 并追加到 resultStr
+		/// @remark 遇到无效的输入时以其位置及长度调用 onInvalid，之后从其后继续转换，onInvalid 可写入替换字符或抛出异常，
+		///         解码失败的序列按 rule 划分，目标编码无法表示的码点作为整体处理
+		///         isFinal 为 false 时 input 结尾不完整的码点视为尚未结束，不作处理
+		///         存在 FastTranscoder 时分块转换到栈上的缓冲区
+		/// @return 已处理的编码单元数量，isFinal 为 true 时总为 input 的长度
+		template <Encoding::CodePage::CodePageType ToCodePage,
+		          Encoding::CodePage::CodePageType FromCodePage, typename StringType,
+		          typename ErrorHandler>
+		std::size_t TranscodeAppend(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    StringType& resultStr, ReplacementRule rule, bool isFinal, ErrorHandler&& onInvalid)
+		{
+			using FromCodePageTrait = Encoding::CodePage::CodePageTrait<FromCodePage>;
+
+			std::size_t position{};
+			if constexpr (HasFastTranscoder<FromCodePage, ToCodePage>)
+			{
+				using Kernel = FastTranscoder<FromCodePage, ToCodePage>;
+				using OutputCharType =
+				    typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType;
+
+				constexpr std::size_t OutputBufferSize = 1024;
+				constexpr std::size_t InputChunkSize = OutputBufferSize / Kernel::MaxExpansion;
+
+				OutputCharType buffer[OutputBufferSize];
+				while (position < input.size())
+				{
+					const auto rest = input.subspan(position);
+					const auto chunkSize = std::min(rest.size(), InputChunkSize);
+					const auto result = Kernel::Transcode(rest.first(chunkSize), buffer);
+					resultStr.Append(std::span<const OutputCharType>(buffer, result.WrittenCount));
+					position += result.ReadCount;
+
+					if (result.Status == TranscodeStatus::Done ||
+					    (result.Status == TranscodeStatus::Incomplete && chunkSize != rest.size()))
+					{
+						// 被分块截断的码点将在下一块中转换
+						continue;
+					}
+
+					if (result.Status == TranscodeStatus::Incomplete && !isFinal)
+					{
+						break;
+					}
+
+					const auto length =
+					    GetInvalidSequenceLength<FromCodePage>(input.subspan(position), rule);
+					onInvalid(position, length);
+					position += length;
+				}
+			}
+			else
+			{
+				while (position < input.size())
+				{
+					const auto rest = input.subspan(position);
+					// 为 0 时表示解码失败
+					std::size_t advanceCount{};
+					auto isIncomplete = false;
+					Encoding::CodePointType codePoint{};
+					if constexpr (FromCodePageTrait::IsVariableWidth)
+					{
+						FromCodePageTrait::ToCodePoint(rest, [&](auto const& result) {
+							constexpr auto ResultCode =
+							    Encoding::GetEncodingResultCode<decltype(result)>;
+							if constexpr (ResultCode == Encoding::EncodingResultCode::Accept)
+							{
+								codePoint = result.Result;
+								advanceCount = result.AdvanceCount;
+							}
+							else
+							{
+								isIncomplete =
+								    ResultCode == Encoding::EncodingResultCode::Incomplete;
+							}
+						});
+					}
+					else
+					{
+						FromCodePageTrait::ToCodePoint(rest[0], [&](auto const& result) {
+							if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
+							              Encoding::EncodingResultCode::Accept)
+							{
+								codePoint = result.Result;
+								advanceCount = 1;
+							}
+						});
+					}
+
+					if (!advanceCount)
+					{
+						if (isIncomplete && !isFinal)
+						{
+							break;
+						}
+
+						const auto length = GetInvalidSequenceLength<FromCodePage>(rest, rule);
+						onInvalid(position, length);
+						position += length;
+						continue;
+					}
+
+					auto isEncoded = false;
+					Encoding::CodePage::CodePageTrait<ToCodePage>::FromCodePoint(
+					    codePoint, [&](auto const& result) {
+						    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
+						                  Encoding::EncodingResultCode::Accept)
+						    {
+							    resultStr.Append(result.Result);
+							    isEncoded = true;
+						    }
+					    });
+					if (!isEncoded)
+					{
+						onInvalid(position, advanceCount);
+					}
+					position += advanceCount;
+				}
+			}
+
+			return position;
+		}
+
+		/// @brief  可改变长度并直接写入内容的字符串，Resize 与 GetSize 使用相同的长度约定
+		template <typename StringType, typename CharType>
+		concept ResizableString = requires(StringType& str, std::size_t size)
+		{
+			str.Resize(size);
+			{
+				str.GetData()
+				} -> std::same_as<CharType*>;
+		};
+
+		/// @brief  按编码后的长度一次性预留 resultStr 的空间
+		/// @remark 仅用于可快速计数的编码对，其余编码对计数的开销与编码相当，不做预留
+		template <Encoding::CodePage::CodePageType ToCodePage,
+		          Encoding::CodePage::CodePageType FromCodePage, typename StringType>
+		void ReserveEncodedLength(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    StringType& resultStr)
+		{
+			if constexpr (HasFastTranscoder<FromCodePage, ToCodePage> &&
+			              requires { resultStr.Reserve(std::size_t{}); })
+			{
+				resultStr.Reserve(FastTranscoder<FromCodePage, ToCodePage>::GetLength(input));
+			}
+		}
+
+		/// @brief  转换 input 并追加到 resultStr，遇到无效的输入时抛出 EncodingFailedException
+		/// @remark 可快速计数的编码对预先计算长度，resultStr 可改变长度时一次性改变其长度并直接写入其存储，
+		///         否则一次性预留空间后追加
+		template <Encoding::CodePage::CodePageType ToCodePage,
+		          Encoding::CodePage::CodePageType FromCodePage, typename StringType>
+		void EncodeAppend(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    StringType& resultStr)
+		{
+			if constexpr (HasFastTranscoder<FromCodePage, ToCodePage>)
+			{
+				using Kernel = FastTranscoder<FromCodePage, ToCodePage>;
+				using OutputCharType =
+				    typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType;
+
+				if constexpr (ResizableString<StringType, OutputCharType>)
+				{
+					// GetSize 可能包含结尾的空字符，改变长度时保持其差值
+					const auto contentSize = resultStr.GetView().GetTrimmedSpan().size();
+					const auto extraSize = resultStr.GetSize() - contentSize;
+					resultStr.Resize(contentSize + Kernel::GetLength(input) + extraSize);
+
+					// 计数按编码单元累加，有效的前缀写入的长度不会超过整个输入计得的长度，遇到无效的输入时停止
+					if (Kernel::Transcode(input, resultStr.GetData() + contentSize).Status !=
+					    TranscodeStatus::Done)
+					{
+						resultStr.Resize(contentSize + extraSize);
+						CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Encoding failed"));
+					}
+				}
+				else
+				{
+					ReserveEncodedLength<ToCodePage, FromCodePage>(input, resultStr);
+					TranscodeAppend<ToCodePage, FromCodePage>(
+					    input, resultStr, ReplacementRule::PerCodeUnit, true,
+					    [](std::size_t, std::size_t) {
+						    CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Encoding failed"));
+					    });
+				}
+			}
+			else
+			{
+				Encoding::Encoder<FromCodePage, ToCodePage>::EncodeAll(
+				    input, [&](auto const& result) {
+					    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
+					                  Encoding::EncodingResultCode::Accept)
+					    {
+						    resultStr.Append(result.Result);
+					    }
+					    else
+					    {
+						    CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Encoding failed"));
+					    }
+				    });
+			}
+		}
+
+		struct IgnoreEncodingError
+		{
+			constexpr void operator()(std::size_t, std::size_t) const noexcept
+			{
+			}
+		};
+
+		/// @brief  单遍转换 input 并追加到 resultStr，无效的输入按 option 替换
+		/// @remark 遇到无效的输入时写入替换字符并以其位置及长度调用 onError
+		template <Encoding::CodePage::CodePageType ToCodePage,
+		          Encoding::CodePage::CodePageType FromCodePage, typename StringType,
+		          typename ErrorHandler>
+		void EncodeAppendWithReplacement(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    ReplacementOption const& option, StringType& resultStr, ErrorHandler&& onError)
+		{
+			TranscodeAppend<ToCodePage, FromCodePage>(
+			    input, resultStr, option.Rule, true,
+			    [&](std::size_t position, std::size_t length) {
+				    AppendCodePoint<ToCodePage>(option.Replacement, resultStr);
+				    onError(position, length);
+			    });
+		}
+	} // namespace Detail
+
+	namespace Detail
+	{
+		/// @brief  获得 input 编码到 ToCodePage 后的长度，input 中的所有编码单元均被计入
+		template <Encoding::CodePage::CodePageType ToCodePage,
+		          Encoding::CodePage::CodePageType FromCodePage>
+		std::size_t GetEncodedLength(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input)
+		{
+			if constexpr (FromCodePage == ToCodePage)
+			{
+				return input.size();
+			}
+			else if constexpr (HasFastTranscoder<FromCodePage, ToCodePage>)
+			{
+				return FastTranscoder<FromCodePage, ToCodePage>::GetLength(input);
+			}
+			else
+			{
+				std::size_t length{};
+				while (!input.empty())
+				{
+					Encoding::Encoder<FromCodePage, ToCodePage>::EncodeAll(
+					    input, [&](auto const& result) {
+						    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
+						                  Encoding::EncodingResultCode::Accept)
+						    {
+							    input = input.subspan(result.AdvanceCount);
+							    if constexpr (requires { result.Result.size(); })
+							    {
+								    length += result.Result.size();
+							    }
+							    else
+							    {
+								    ++length;
+							    }
+						    }
+						    else
+						    {
+							    // 此时编码中止
+							    input = input.subspan(1);
+						    }
+					    });
+				}
+				return length;
+			}
+		}
+	} // namespace Detail
+
+	/// @brief  获得 str 编码到 ToCodePage 后的长度，以 ToCodePage 的编码单元计，不含结尾的空字符
+	/// @remark 用于预先分配缓冲区，常用编码对仅计数而不完整解码，本函数不校验输入，输入无效时结果仅可作为估计
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent>
+	std::size_t EncodedLength(Encoding::StringView<FromCodePage, Extent> const& str)
+	{
+		return Detail::GetEncodedLength<ToCodePage, FromCodePage>(str.GetTrimmedSpan());
+	}
+
 	template <Encoding::CodePage::CodePageType ToCodePage,
 	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent>
 	Encoding::String<ToCodePage> EncodeTo(Encoding::StringView<FromCodePage, Extent> const& str)
@@ -23,26 +407,35 @@ namespace Cafe::TextUtils
 		else
 		{
 			Encoding::String<ToCodePage> resultStr;
-			Encoding::Encoder<FromCodePage, ToCodePage>::EncodeAll(
-			    str.GetTrimmedSpan(), [&](auto const& result) {
-				    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
-				                  Encoding::EncodingResultCode::Accept)
-				    {
-					    resultStr.Append(result.Result);
-				    }
-				    else
-				    {
-					    CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Encoding failed"));
-				    }
-			    });
+			Detail::EncodeAppend<ToCodePage, FromCodePage>(str.GetTrimmedSpan(), resultStr);
 			return resultStr;
 		}
 	}
 
+	/// @brief  使用 allocator 分配结果的 EncodeTo，allocator 将被 rebind 到目标编码的编码单元类型
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent,
+	          Detail::AllocatorType Allocator>
+	Detail::StringWithAllocator<ToCodePage, Allocator>
+	EncodeTo(Encoding::StringView<FromCodePage, Extent> const& str, Allocator const& allocator)
+	{
+		auto resultStr = Detail::MakeStringWithAllocator<ToCodePage>(allocator);
+		if constexpr (FromCodePage == ToCodePage)
+		{
+			resultStr.Append(str);
+		}
+		else
+		{
+			Detail::EncodeAppend<ToCodePage, FromCodePage>(str.GetTrimmedSpan(), resultStr);
+		}
+		return resultStr;
+	}
+
+	/// @brief  编码 str，每个无效的编码单元替换为 replacement
 	template <Encoding::CodePage::CodePageType ToCodePage,
 	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent>
 	Encoding::String<ToCodePage>
-	EncodeToWithReplacement(Encoding::StringView<FromCodePage, Extent> str,
+	EncodeToWithReplacement(Encoding::StringView<FromCodePage, Extent> const& str,
 	                        Encoding::CodePointType replacement = 0xFFFD)
 	{
 		if constexpr (FromCodePage == ToCodePage)
@@ -51,38 +444,56 @@ namespace Cafe::TextUtils
 		}
 		else
 		{
-			str = str.Trim();
 			Encoding::String<ToCodePage> resultStr;
-			while (!str.IsEmpty())
-			{
-				Encoding::Encoder<FromCodePage, ToCodePage>::EncodeAll(str, [&](auto const&
-				                                                                    result) {
-					if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
-					              Encoding::EncodingResultCode::Accept)
-					{
-						str = str.SubStr(result.AdvanceCount);
-						resultStr.Append(result.Result);
-					}
-					else
-					{
-						// 此时编码中止
-						str = str.SubStr(1);
-						Encoding::CodePage::CodePageTrait<ToCodePage>::FromCodePoint(
-						    replacement, [&](auto const& result) {
-							    if constexpr (Encoding::GetEncodingResultCode<decltype(result)> ==
-							                  Encoding::EncodingResultCode::Accept)
-							    {
-								    resultStr.Append(result.Result);
-							    }
-						    });
-					}
-				});
-			}
-
+			Detail::ReserveEncodedLength<ToCodePage, FromCodePage>(str.GetTrimmedSpan(), resultStr);
+			Detail::EncodeAppendWithReplacement<ToCodePage, FromCodePage>(
+			    str.GetTrimmedSpan(), { replacement, ReplacementRule::PerCodeUnit }, resultStr,
+			    Detail::IgnoreEncodingError{});
 			return resultStr;
 		}
 	}
 
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent,
+	          Detail::AllocatorType Allocator>
+	Detail::StringWithAllocator<ToCodePage, Allocator>
+	EncodeToWithReplacement(Encoding::StringView<FromCodePage, Extent> const& str,
+	                        Allocator const& allocator,
+	                        Encoding::CodePointType replacement = 0xFFFD)
+	{
+		auto resultStr = Detail::MakeStringWithAllocator<ToCodePage>(allocator);
+		if constexpr (FromCodePage == ToCodePage)
+		{
+			resultStr.Append(str);
+		}
+		else
+		{
+			Detail::ReserveEncodedLength<ToCodePage, FromCodePage>(str.GetTrimmedSpan(), resultStr);
+			Detail::EncodeAppendWithReplacement<ToCodePage, FromCodePage>(
+			    str.GetTrimmedSpan(), { replacement, ReplacementRule::PerCodeUnit }, resultStr,
+			    Detail::IgnoreEncodingError{});
+		}
+		return resultStr;
+	}
+
+	/// @brief  单遍编码 str，无效的输入按 option 替换
+	/// @remark 源编码与目标编码相同时同样校验并替换无效的输入
+	/// @param  onError 对每处无效的输入以其位置及长度调用，均以源编码的编码单元计
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent,
+	          typename ErrorHandler = Detail::IgnoreEncodingError>
+	requires std::invocable<ErrorHandler&, std::size_t, std::size_t>
+	Encoding::String<ToCodePage>
+	EncodeToWithReplacement(Encoding::StringView<FromCodePage, Extent> const& str,
+	                        ReplacementOption const& option, ErrorHandler&& onError = {})
+	{
+		Encoding::String<ToCodePage> resultStr;
+		Detail::ReserveEncodedLength<ToCodePage, FromCodePage>(str.GetTrimmedSpan(), resultStr);
+		Detail::EncodeAppendWithReplacement<ToCodePage, FromCodePage>(str.GetTrimmedSpan(), option,
+		                                                              resultStr, onError);
+		return resultStr;
+	}
+
 	template <Encoding::CodePage::CodePageType CodePageValue>
 	constexpr Encoding::StringView<CodePageValue> AsNullTerminatedStringView(
 	    const typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType* str) noexcept
@@ -102,11 +513,83 @@ namespace Cafe::TextUtils
 
 #if __has_include(<Cafe/Encoding/RuntimeEncoding.h>)
 
+	namespace Detail
+	{
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		using CodePageConstant =
+		    std::integral_constant<Encoding::CodePage::CodePageType, CodePageValue>;
+
+		/// @brief  若 codePage 为 UTF-8 或本机字节序的 UTF-16、UTF-32，以对应的 CodePageConstant 调用 func
+		/// @return func 的返回值，codePage 为其他编码时返回 false
+		template <typename Func>
+		bool VisitUnicodeCodePage(Encoding::CodePage::CodePageType codePage, Func&& func)
+		{
+			switch (codePage)
+			{
+			case Encoding::CodePage::Utf8:
+				return func(CodePageConstant<Encoding::CodePage::Utf8>{});
+			case NativeUtf16:
+				return func(CodePageConstant<NativeUtf16>{});
+			case NativeUtf32:
+				return func(CodePageConstant<NativeUtf32>{});
+			default:
+				return false;
+			}
+		}
+
+		/// @brief  将编码单元以字节形式追加到 std::vector<std::byte>，用于 EncodeAppend
+		template <typename CharType>
+		struct ByteVectorAppender
+		{
+			std::vector<std::byte>& Bytes;
+
+			void Append(std::span<const CharType> const& units)
+			{
+				const auto bytes = std::as_bytes(units);
+				Bytes.insert(Bytes.end(), bytes.begin(), bytes.end());
+			}
+
+			void Append(CharType unit)
+			{
+				Append(std::span<const CharType>(&unit, 1));
+			}
+		};
+	} // namespace Detail
+
+	/// @remark fromCodePage 为 UTF-8 或本机字节序的 UTF-16、UTF-32 且 span 满足对齐要求时，
+	///         预先计算长度并一次性分配结果
+	///         此时若 fromCodePage 与 ToCodePage 相同，直接复制 span 而不校验其内容，无效的输入不会引发异常
+	///         与其他编码一致，span 中的所有编码单元均被转换，结尾的空字符不会被去除
 	template <Encoding::CodePage::CodePageType ToCodePage>
 	Encoding::String<ToCodePage> EncodeFromRuntime(Encoding::CodePage::CodePageType fromCodePage,
 	                                               std::span<const std::byte> const& span)
 	{
 		Encoding::String<ToCodePage> resultStr;
+		if (Detail::VisitUnicodeCodePage(fromCodePage, [&](auto codePage) {
+			    constexpr auto FromCodePage = decltype(codePage)::value;
+			    using CharType = typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType;
+			    if (span.size() % sizeof(CharType) ||
+			        reinterpret_cast<std::uintptr_t>(span.data()) % alignof(CharType))
+			    {
+				    return false;
+			    }
+
+			    const std::span units(reinterpret_cast<const CharType*>(span.data()),
+			                          span.size() / sizeof(CharType));
+			    if constexpr (FromCodePage == ToCodePage)
+			    {
+				    resultStr.Append(units);
+			    }
+			    else
+			    {
+				    Detail::EncodeAppend<ToCodePage, FromCodePage>(units, resultStr);
+			    }
+			    return true;
+		    }))
+		{
+			return resultStr;
+		}
+
 		resultStr.Reserve(span.size());
 		Encoding::RuntimeEncoding::RuntimeEncoder<ToCodePage>::EncodeAllFrom(
 		    fromCodePage, std::as_bytes(span), [&](auto const& result) {
@@ -122,11 +605,32 @@ namespace Cafe::TextUtils
 		return resultStr;
 	}
 
+	/// @remark toCodePage 为 UTF-8 或本机字节序的 UTF-16、UTF-32 时，预先计算长度并一次性分配结果
+	///         此时若 toCodePage 与 FromCodePage 相同，直接复制 str 而不校验其内容，无效的输入不会引发异常
 	template <Encoding::CodePage::CodePageType FromCodePage>
 	std::vector<std::byte> EncodeToRuntime(Encoding::StringView<FromCodePage> const& str,
 	                                       Encoding::CodePage::CodePageType toCodePage)
 	{
 		std::vector<std::byte> resultVec;
+		if (Detail::VisitUnicodeCodePage(toCodePage, [&](auto codePage) {
+			    constexpr auto ToCodePage = decltype(codePage)::value;
+			    using CharType = typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType;
+			    resultVec.reserve(EncodedLength<ToCodePage>(str) * sizeof(CharType));
+			    Detail::ByteVectorAppender<CharType> appender{ resultVec };
+			    if constexpr (FromCodePage == ToCodePage)
+			    {
+				    appender.Append(str.GetTrimmedSpan());
+			    }
+			    else
+			    {
+				    Detail::EncodeAppend<ToCodePage, FromCodePage>(str.GetTrimmedSpan(), appender);
+			    }
+			    return true;
+		    }))
+		{
+			return resultVec;
+		}
+
 		resultVec.reserve(str.GetSize());
 		Encoding::RuntimeEncoding::RuntimeEncoder<FromCodePage>::EncodeAllTo(
 		    str.GetTrimmedSpan(), toCodePage, [&](auto const& result) {
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <Cafe/TextUtils/Misc.h>
+#include <algorithm>
+#include <concepts>
+#include <exception>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Cafe::TextUtils
+{
+	struct ParallelEncodeOption
+	{
+		/// @brief  工作线程数，为 0 时使用 std::thread::hardware_concurrency()
+		std::size_t ThreadCount = 0;
+		/// @brief  每块至少包含的编码单元数，输入较短时使用较少的线程
+		std::size_t MinChunkSize = std::size_t{ 1 } << 20;
+	};
+
+	namespace Detail
+	{
+		/// @brief  可以不经解码找到码点边界的编码
+		template <Encoding::CodePage::CodePageType CodePageValue>
+		concept SplittableCodePage =
+		    CodePageValue == Encoding::CodePage::Utf8 || CodePageValue == NativeUtf16 ||
+		    CodePageValue == NativeUtf32 || CodePageValue == Encoding::CodePage::CodePoint;
+
+		/// @brief  将 position 向前调整到串行转换时必然经过的位置，使分块转换的结果与串行转换完全相同
+		/// @remark position 须在 (0, input.size()) 之间，结果可能为 0
+		template <Encoding::CodePage::CodePageType FromCodePage>
+		std::size_t FindCodePointBoundary(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    std::size_t position) noexcept
+		{
+			if constexpr (FromCodePage == Encoding::CodePage::Utf8)
+			{
+				// 非续字节不会位于任何序列的中间，连续 4 个以上的续字节中靠后的部分均单独作为无效的输入
+				for (std::size_t i = 0; i <= std::min<std::size_t>(3, position); ++i)
+				{
+					if (!IsUtf8Continuation(input[position - i]))
+					{
+						return position - i;
+					}
+				}
+			}
+			else if constexpr (FromCodePage == NativeUtf16)
+			{
+				if (input[position] >= 0xDC00 && input[position] <= 0xDFFF &&
+				    input[position - 1] >= 0xD800 && input[position - 1] <= 0xDBFF)
+				{
+					return position - 1;
+				}
+			}
+
+			return position;
+		}
+
+		/// @brief  按 option 将 input 分块，返回各块的边界，第 i 块为 [bounds[i], bounds[i + 1])
+		/// @remark 块数不超过线程数，且每块（除最后一块外）至少包含约 MinChunkSize 个编码单元
+		template <Encoding::CodePage::CodePageType FromCodePage>
+		std::vector<std::size_t> SplitForParallelEncode(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    ParallelEncodeOption const& option)
+		{
+			const auto threadCount =
+			    option.ThreadCount
+			        ? option.ThreadCount
+			        : std::max(static_cast<std::size_t>(std::thread::hardware_concurrency()),
+			                   std::size_t{ 1 });
+			const auto chunkCount = std::clamp(
+			    input.size() / std::max(option.MinChunkSize, std::size_t{ 1 }), std::size_t{ 1 },
+			    threadCount);
+
+			std::vector<std::size_t> bounds(chunkCount + 1);
+			bounds[chunkCount] = input.size();
+			for (std::size_t i = 1; i < chunkCount; ++i)
+			{
+				bounds[i] = std::max(bounds[i - 1], FindCodePointBoundary<FromCodePage>(
+				                                        input, input.size() / chunkCount * i));
+			}
+
+			return bounds;
+		}
+
+		/// @brief  并行地对 [0, chunkCount) 中的每个序号调用 func
+		/// @remark 调用线程负责序号 0，各序号抛出的异常在全部完成后按序号的顺序重新抛出
+		template <typename Func>
+		void ForEachChunkParallel(std::size_t chunkCount, Func&& func)
+		{
+			std::vector<std::exception_ptr> exceptions(chunkCount);
+			const auto run = [&](std::size_t index) noexcept {
+				try
+				{
+					func(index);
+				}
+				catch (...)
+				{
+					exceptions[index] = std::current_exception();
+				}
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(chunkCount - 1);
+			const auto join = [&] {
+				for (auto& thread : workers)
+				{
+					thread.join();
+				}
+			};
+
+			try
+			{
+				for (std::size_t i = 1; i < chunkCount; ++i)
+				{
+					workers.emplace_back(run, i);
+				}
+			}
+			catch (...)
+			{
+				join();
+				throw;
+			}
+
+			run(0);
+			join();
+
+			for (const auto& exception : exceptions)
+			{
+				if (exception)
+				{
+					std::rethrow_exception(exception);
+				}
+			}
+		}
+
+		/// @brief  写入预先分配的存储的 sink
+		template <typename CharType>
+		struct SliceWriter
+		{
+			CharType* Current;
+
+			void Append(std::span<const CharType> const& units) noexcept
+			{
+				Current = std::copy(units.begin(), units.end(), Current);
+			}
+
+			void Append(CharType unit) noexcept
+			{
+				*Current++ = unit;
+			}
+		};
+
+		/// @brief  仅计算写入长度的 sink
+		template <typename CharType>
+		struct LengthCounter
+		{
+			std::size_t Length{};
+
+			void Append(std::span<const CharType> const& units) noexcept
+			{
+				Length += units.size();
+			}
+
+			void Append(CharType) noexcept
+			{
+				++Length;
+			}
+		};
+
+		/// @brief  转换 input 并写入 output，遇到无效的输入时抛出 EncodingFailedException
+		/// @remark output 的长度须为 GetEncodedLength 计得的长度，输入有效时恰好写满，
+		///         计数按编码单元累加，因此遇到无效的输入时不会越过 output 的结尾
+		template <Encoding::CodePage::CodePageType ToCodePage,
+		          Encoding::CodePage::CodePageType FromCodePage>
+		void EncodeInto(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType* output)
+		{
+			if constexpr (HasFastTranscoder<FromCodePage, ToCodePage>)
+			{
+				if (FastTranscoder<FromCodePage, ToCodePage>::Transcode(input, output).Status !=
+				    TranscodeStatus::Done)
+				{
+					CAFE_THROW(EncodingFailedException, CAFE_UTF8_SV("Encoding failed"));
+				}
+			}
+			else
+			{
+				using ToCharType = typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType;
+				SliceWriter<ToCharType> writer{ output };
+				EncodeAppend<ToCodePage, FromCodePage>(input, writer);
+			}
+		}
+
+		/// @brief  并行地计算 bounds 划分的各块转换后的长度，一次性分配结果后并行地将各块写入其所属的部分
+		/// @remark getLength(块序号, 块) 返回该块转换后的长度，encodeChunk(块序号, 块, 写入位置) 转换该块，
+		///         两者抛出的异常均按块的顺序重新抛出
+		///         结果不可改变长度时写入临时的缓冲区后一次性追加
+		template <Encoding::CodePage::CodePageType ToCodePage,
+		          Encoding::CodePage::CodePageType FromCodePage, typename LengthGetter,
+		          typename ChunkEncoder>
+		Encoding::String<ToCodePage> EncodeParallel(
+		    std::span<const typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType> input,
+		    std::vector<std::size_t> const& bounds, LengthGetter&& getLength,
+		    ChunkEncoder&& encodeChunk)
+		{
+			using ToCharType = typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType;
+
+			const auto chunkCount = bounds.size() - 1;
+			const auto getChunk = [&](std::size_t index) {
+				return input.subspan(bounds[index], bounds[index + 1] - bounds[index]);
+			};
+
+			// offsets[i] 为第 i 块的结果在整个结果中的位置
+			std::vector<std::size_t> offsets(chunkCount + 1);
+			ForEachChunkParallel(chunkCount, [&](std::size_t index) {
+				offsets[index + 1] = getLength(index, getChunk(index));
+			});
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+			const auto encodeAll = [&](ToCharType* output) {
+				ForEachChunkParallel(chunkCount, [&](std::size_t index) {
+					encodeChunk(index, getChunk(index), output + offsets[index]);
+				});
+			};
+
+			Encoding::String<ToCodePage> resultStr;
+			if constexpr (ResizableString<Encoding::String<ToCodePage>, ToCharType>)
+			{
+				// GetSize 可能包含结尾的空字符，改变长度时保持其差值
+				resultStr.Resize(offsets[chunkCount] + resultStr.GetSize());
+				encodeAll(resultStr.GetData());
+			}
+			else
+			{
+				std::vector<ToCharType> buffer(offsets[chunkCount]);
+				encodeAll(buffer.data());
+				resultStr.Reserve(buffer.size());
+				resultStr.Append(std::span<const ToCharType>(buffer));
+			}
+
+			return resultStr;
+		}
+	} // namespace Detail
+
+	/// @brief  多线程的 EncodeTo，结果与 EncodeTo 完全相同
+	/// @remark 输入在码点边界处分块，各块并行地计算长度，一次性分配结果后各块并行地直接转换到结果中属于该块的部分
+	///         无法不经解码找到码点边界的源编码将串行转换
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent>
+	Encoding::String<ToCodePage>
+	EncodeToParallel(Encoding::StringView<FromCodePage, Extent> const& str,
+	                 ParallelEncodeOption const& option = {})
+	{
+		if constexpr (FromCodePage == ToCodePage || !Detail::SplittableCodePage<FromCodePage>)
+		{
+			return EncodeTo<ToCodePage>(str);
+		}
+		else
+		{
+			const auto input = str.GetTrimmedSpan();
+			return Detail::EncodeParallel<ToCodePage, FromCodePage>(
+			    input, Detail::SplitForParallelEncode<FromCodePage>(input, option),
+			    [](std::size_t, auto const& chunk) {
+				    return Detail::GetEncodedLength<ToCodePage, FromCodePage>(chunk);
+			    },
+			    [](std::size_t, auto const& chunk, auto* output) {
+				    Detail::EncodeInto<ToCodePage, FromCodePage>(chunk, output);
+			    });
+		}
+	}
+
+	/// @brief  多线程的 EncodeToWithReplacement，结果及报告的错误与 EncodeToWithReplacement 完全相同
+	/// @remark onError 在全部转换完成后由调用线程按位置顺序调用
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType FromCodePage, std::size_t Extent,
+	          typename ErrorHandler = Detail::IgnoreEncodingError>
+	requires std::invocable<ErrorHandler&, std::size_t, std::size_t>
+	Encoding::String<ToCodePage> EncodeToWithReplacementParallel(
+	    Encoding::StringView<FromCodePage, Extent> const& str, ReplacementOption const& option,
+	    ParallelEncodeOption const& parallelOption = {}, ErrorHandler&& onError = {})
+	{
+		if constexpr (!Detail::SplittableCodePage<FromCodePage>)
+		{
+			return EncodeToWithReplacement<ToCodePage>(str, option, onError);
+		}
+		else
+		{
+			using ToCharType = typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType;
+			constexpr auto IsErrorIgnored =
+			    std::is_same_v<std::remove_cvref_t<ErrorHandler>, Detail::IgnoreEncodingError>;
+
+			const auto input = str.GetTrimmedSpan();
+			const auto bounds = Detail::SplitForParallelEncode<FromCodePage>(input, parallelOption);
+
+			// 各块的错误以块内的位置记录
+			std::vector<std::vector<std::pair<std::size_t, std::size_t>>> errors;
+			if constexpr (!IsErrorIgnored)
+			{
+				errors.resize(bounds.size() - 1);
+			}
+
+			// 替换使长度无法仅凭计数得到，因此以仅计数的 sink 完整转换一次，同时记录错误
+			auto resultStr = Detail::EncodeParallel<ToCodePage, FromCodePage>(
+			    input, bounds,
+			    [&](std::size_t index, auto const& chunk) {
+				    Detail::LengthCounter<ToCharType> counter;
+				    if constexpr (IsErrorIgnored)
+				    {
+					    Detail::EncodeAppendWithReplacement<ToCodePage, FromCodePage>(
+					        chunk, option, counter, Detail::IgnoreEncodingError{});
+				    }
+				    else
+				    {
+					    Detail::EncodeAppendWithReplacement<ToCodePage, FromCodePage>(
+					        chunk, option, counter,
+					        [&chunkErrors = errors[index]](std::size_t position,
+					                                       std::size_t length) {
+						        chunkErrors.emplace_back(position, length);
+					        });
+				    }
+				    return counter.Length;
+			    },
+			    [&](std::size_t, auto const& chunk, ToCharType* output) {
+				    Detail::SliceWriter<ToCharType> writer{ output };
+				    Detail::EncodeAppendWithReplacement<ToCodePage, FromCodePage>(
+				        chunk, option, writer, Detail::IgnoreEncodingError{});
+			    });
+
+			if constexpr (!IsErrorIgnored)
+			{
+				for (std::size_t i = 0; i + 1 < bounds.size(); ++i)
+				{
+					for (const auto& [position, length] : errors[i])
+					{
+						onError(bounds[i] + position, length);
+					}
+				}
+			}
+
+			return resultStr;
+		}
+	}
+} // namespace Cafe::TextUtils
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Cafe/TextUtils/CodePointIterator.h>
+#include <Cafe/TextUtils/Misc.h>
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace Cafe::TextUtils
+{
+	/// @brief  增量转换器，输入可分多次提供，跨越输入边界的码点暂存于内部直至补全
+	/// @remark 内部仅暂存至多 GetMaxWidth<FromCodePage>() 个编码单元，不复制或拼接输入，
+	///         因此可以固定的内存转换任意长度的流
+	///         sink 须具有与 Encoding::String<ToCodePage> 相同的 Append 方法
+	///         遇到无效的输入时由 OnEncodingFailedPolicy 决定抛出异常或写入替换字符，无效的输入按 rule 划分
+	template <Encoding::CodePage::CodePageType FromCodePage,
+	          Encoding::CodePage::CodePageType ToCodePage,
+	          typename OnEncodingFailedPolicy = ThrowOnEncodingFailedPolicy>
+	class Transcoder
+	{
+	public:
+		using CharType = typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType;
+
+		static constexpr std::size_t MaxPendingSize =
+		    Encoding::CodePage::GetMaxWidth<FromCodePage>();
+
+		constexpr explicit Transcoder(
+		    ReplacementRule rule = ReplacementRule::MaximalSubpart) noexcept
+		    : m_Rule{ rule }
+		{
+		}
+
+		/// @brief  转换 input 并写入 sink，结尾不完整的码点暂存至下次调用
+		template <typename Sink>
+		void Feed(std::span<const CharType> input, Sink& sink)
+		{
+			while (m_PendingSize && !input.empty())
+			{
+				// 以 input 开头的部分补全暂存的码点，补全后剩余的部分从 input 中继续
+				std::array<CharType, MaxPendingSize> buffer;
+				const auto fillSize = std::min(input.size(), MaxPendingSize - m_PendingSize);
+				const auto end = std::copy_n(m_Pending.begin(), m_PendingSize, buffer.begin());
+				std::copy_n(input.begin(), fillSize, end);
+
+				const auto size = m_PendingSize + fillSize;
+				const auto consumed =
+				    TranscodeAppend(std::span<const CharType>(buffer.data(), size), sink, false);
+				if (consumed >= m_PendingSize)
+				{
+					input = input.subspan(consumed - m_PendingSize);
+					m_PendingSize = 0;
+				}
+				else
+				{
+					std::copy(buffer.begin() + consumed, buffer.begin() + size, m_Pending.begin());
+					m_PendingSize = size - consumed;
+					input = input.subspan(fillSize);
+				}
+			}
+
+			if (!input.empty())
+			{
+				const auto rest = input.subspan(TranscodeAppend(input, sink, false));
+				std::copy(rest.begin(), rest.end(), m_Pending.begin());
+				m_PendingSize = rest.size();
+			}
+		}
+
+		template <std::size_t Extent, typename Sink>
+		void Feed(Encoding::StringView<FromCodePage, Extent> const& input, Sink& sink)
+		{
+			Feed(input.GetTrimmedSpan(), sink);
+		}
+
+		/// @brief  结束输入，暂存的不完整码点作为无效的输入处理
+		/// @remark 之后可以继续用于转换新的输入
+		template <typename Sink>
+		void Finish(Sink& sink)
+		{
+			if (m_PendingSize)
+			{
+				const auto pending = m_Pending;
+				const auto pendingSize = std::exchange(m_PendingSize, 0);
+				TranscodeAppend(std::span<const CharType>(pending.data(), pendingSize), sink, true);
+			}
+		}
+
+		/// @brief  丢弃暂存的不完整码点
+		constexpr void Reset() noexcept
+		{
+			m_PendingSize = 0;
+		}
+
+		/// @brief  获得暂存的编码单元数量
+		constexpr std::size_t GetPendingSize() const noexcept
+		{
+			return m_PendingSize;
+		}
+
+	private:
+		ReplacementRule m_Rule;
+		std::array<CharType, MaxPendingSize> m_Pending{};
+		std::size_t m_PendingSize{};
+
+		template <typename Sink>
+		std::size_t TranscodeAppend(std::span<const CharType> input, Sink& sink, bool isFinal)
+		{
+			return Detail::TranscodeAppend<ToCodePage, FromCodePage>(
+			    input, sink, m_Rule, isFinal, [&](std::size_t, std::size_t) {
+				    Detail::AppendCodePoint<ToCodePage>(
+				        OnEncodingFailedPolicy::GetReplacementCodePoint(), sink);
+			    });
+		}
+	};
+} // namespace Cafe::TextUtils
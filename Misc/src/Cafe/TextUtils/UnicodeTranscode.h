@@ -0,0 +1,562 @@
+#pragma once
+
+#include <Cafe/Encoding/CodePage.h>
+#include <Cafe/TextUtils/Config.h>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace Cafe::TextUtils
+{
+	namespace Detail
+	{
+		enum class TranscodeStatus
+		{
+			// 已转换全部输入
+			Done,
+			// 输入结尾为不完整的码点，可能在之后补全
+			Incomplete,
+			// 遇到无法转换的输入
+			Invalid,
+		};
+
+		struct TranscodeResult
+		{
+			/// @brief  已转换的输入编码单元数量，出错时为出错的位置
+			std::size_t ReadCount;
+			/// @brief  写入的输出编码单元数量
+			std::size_t WrittenCount;
+			TranscodeStatus Status;
+		};
+
+		constexpr auto NativeUtf16 = std::endian::native == std::endian::little
+		                                 ? Encoding::CodePage::Utf16LittleEndian
+		                                 : Encoding::CodePage::Utf16BigEndian;
+		constexpr auto NativeUtf32 = std::endian::native == std::endian::little
+		                                 ? Encoding::CodePage::Utf32LittleEndian
+		                                 : Encoding::CodePage::Utf32BigEndian;
+
+		/// @brief  将 input 开头的 ASCII 字符直接扩展写入 output
+		/// @return 处理的编码单元数量，遇到非 ASCII 字符时停止
+		template <typename OutputCharType>
+		std::size_t WidenAscii(const char8_t* input, std::size_t size,
+		                       OutputCharType* output) noexcept
+		{
+			std::size_t i{};
+#if CAFE_TEXTUTILS_HAS_AVX2
+			for (; i + 32 <= size; i += 32)
+			{
+				const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+				if (_mm256_movemask_epi8(block))
+				{
+					break;
+				}
+
+				if constexpr (sizeof(OutputCharType) == 1)
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), block);
+				}
+				else if constexpr (sizeof(OutputCharType) == 2)
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i),
+					                    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(block)));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i + 16),
+					                    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(block, 1)));
+				}
+				else
+				{
+					for (std::size_t j = 0; j < 32; j += 8)
+					{
+						_mm256_storeu_si256(
+						    reinterpret_cast<__m256i*>(output + i + j),
+						    _mm256_cvtepu8_epi32(
+						        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i + j))));
+					}
+				}
+			}
+#endif
+#if CAFE_TEXTUTILS_HAS_SSE2
+			const auto zero = _mm_setzero_si128();
+			for (; i + 16 <= size; i += 16)
+			{
+				const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+				if (_mm_movemask_epi8(block))
+				{
+					break;
+				}
+
+				if constexpr (sizeof(OutputCharType) == 1)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), block);
+				}
+				else
+				{
+					const auto low = _mm_unpacklo_epi8(block, zero);
+					const auto high = _mm_unpackhi_epi8(block, zero);
+					if constexpr (sizeof(OutputCharType) == 2)
+					{
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), low);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8), high);
+					}
+					else
+					{
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+						                 _mm_unpacklo_epi16(low, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 4),
+						                 _mm_unpackhi_epi16(low, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8),
+						                 _mm_unpacklo_epi16(high, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 12),
+						                 _mm_unpackhi_epi16(high, zero));
+					}
+				}
+			}
+#else
+			for (; i + 8 <= size; i += 8)
+			{
+				std::uint64_t block;
+				std::memcpy(&block, input + i, sizeof(block));
+				if (block & 0x8080808080808080)
+				{
+					break;
+				}
+
+				for (std::size_t j = 0; j < 8; ++j)
+				{
+					output[i + j] = static_cast<OutputCharType>(input[i + j]);
+				}
+			}
+#endif
+			for (; i < size && input[i] < 0x80; ++i)
+			{
+				output[i] = static_cast<OutputCharType>(input[i]);
+			}
+
+			return i;
+		}
+
+		/// @brief  将 input 开头的 ASCII 字符直接收窄写入 output
+		/// @return 处理的编码单元数量，遇到非 ASCII 字符时停止
+		template <typename InputCharType>
+		std::size_t NarrowAscii(const InputCharType* input, std::size_t size,
+		                        char8_t* output) noexcept
+		{
+			std::size_t i{};
+#if CAFE_TEXTUTILS_HAS_SSE2
+			if constexpr (sizeof(InputCharType) == 2)
+			{
+				const auto nonAsciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+				for (; i + 16 <= size; i += 16)
+				{
+					const auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+					const auto high =
+					    _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+					const auto nonAscii = _mm_and_si128(_mm_or_si128(low, high), nonAsciiMask);
+					if (_mm_movemask_epi8(_mm_cmpeq_epi8(nonAscii, _mm_setzero_si128())) != 0xFFFF)
+					{
+						break;
+					}
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+					                 _mm_packus_epi16(low, high));
+				}
+			}
+			else if constexpr (sizeof(InputCharType) == 4)
+			{
+				const auto nonAsciiMask = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+				for (; i + 16 <= size; i += 16)
+				{
+					__m128i parts[4];
+					auto combined = _mm_setzero_si128();
+					for (std::size_t j = 0; j < 4; ++j)
+					{
+						parts[j] =
+						    _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + j * 4));
+						combined = _mm_or_si128(combined, parts[j]);
+					}
+
+					if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(combined, nonAsciiMask),
+					                                     _mm_setzero_si128())) != 0xFFFF)
+					{
+						break;
+					}
+
+					// 值均小于 0x80，有符号饱和不会改变结果
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+					                 _mm_packus_epi16(_mm_packs_epi32(parts[0], parts[1]),
+					                                  _mm_packs_epi32(parts[2], parts[3])));
+				}
+			}
+#endif
+			for (; i < size && input[i] < 0x80; ++i)
+			{
+				output[i] = static_cast<char8_t>(input[i]);
+			}
+
+			return i;
+		}
+
+		constexpr bool IsUtf8Continuation(char8_t unit) noexcept
+		{
+			return (unit & 0xC0) == 0x80;
+		}
+
+		/// @brief  获得 input 开头的无效 UTF-8 序列的最长子部分（maximal subpart）的长度
+		/// @remark 即 Unicode 标准及 WHATWG Encoding 规范中替换为单个 U+FFFD 的部分，结果至少为 1
+		constexpr std::size_t GetUtf8MaximalSubpartLength(std::span<const char8_t> input) noexcept
+		{
+			const auto lead = input[0];
+			std::size_t length;
+			char8_t secondMin = 0x80;
+			char8_t secondMax = 0xBF;
+			if (lead >= 0xC2 && lead <= 0xDF)
+			{
+				length = 2;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF)
+			{
+				length = 3;
+				if (lead == 0xE0)
+				{
+					secondMin = 0xA0;
+				}
+				else if (lead == 0xED)
+				{
+					secondMax = 0x9F;
+				}
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4)
+			{
+				length = 4;
+				if (lead == 0xF0)
+				{
+					secondMin = 0x90;
+				}
+				else if (lead == 0xF4)
+				{
+					secondMax = 0x8F;
+				}
+			}
+			else
+			{
+				return 1;
+			}
+
+			std::size_t i = 1;
+			for (; i < length && i < input.size(); ++i)
+			{
+				const auto unit = input[i];
+				if (i == 1 ? unit < secondMin || unit > secondMax : !IsUtf8Continuation(unit))
+				{
+					break;
+				}
+			}
+
+			return i;
+		}
+
+		/// @brief  从 UTF-8 转换到 UTF-16 或 UTF-32，后者由 OutputCharType 的大小决定
+		/// @remark 拒绝过长编码、代理码点及超过 0x10FFFF 的码点，与逐码点转换的结果相同
+		///         output 的长度不能小于 input 的长度
+		template <typename OutputCharType>
+		TranscodeResult TranscodeFromUtf8(std::span<const char8_t> input,
+		                                  OutputCharType* output) noexcept
+		{
+			const auto size = input.size();
+			const auto data = input.data();
+			std::size_t read{};
+			std::size_t written{};
+
+			while (read < size)
+			{
+				const auto asciiCount = WidenAscii(data + read, size - read, output + written);
+				read += asciiCount;
+				written += asciiCount;
+
+				// 连续的非 ASCII 字符逐个解码，直至下一个 ASCII 字符
+				while (read < size && data[read] >= 0x80)
+				{
+					const std::uint32_t lead = data[read];
+					std::size_t length;
+					char32_t codePoint;
+					if (lead >= 0xC2 && lead <= 0xDF)
+					{
+						length = 2;
+						codePoint = lead & 0x1F;
+					}
+					else if ((lead & 0xF0) == 0xE0)
+					{
+						length = 3;
+						codePoint = lead & 0x0F;
+					}
+					else if (lead >= 0xF0 && lead <= 0xF4)
+					{
+						length = 4;
+						codePoint = lead & 0x07;
+					}
+					else if (lead == 0xC0 || lead == 0xC1)
+					{
+						// 过长编码，但后续的编码单元仍然先行检查以区分不完整的情况
+						length = 2;
+						codePoint = 0;
+					}
+					else
+					{
+						return { read, written, TranscodeStatus::Invalid };
+					}
+
+					for (std::size_t i = 1; i < length; ++i)
+					{
+						if (read + i >= size)
+						{
+							return { read, written, TranscodeStatus::Incomplete };
+						}
+
+						const auto unit = data[read + i];
+						if (!IsUtf8Continuation(unit))
+						{
+							return { read, written, TranscodeStatus::Invalid };
+						}
+						codePoint = (codePoint << 6) | (unit & 0x3F);
+					}
+
+					constexpr char32_t MinCodePoint[] = { 0, 0, 0x80, 0x800, 0x10000 };
+					if (codePoint < MinCodePoint[length] || codePoint > 0x10FFFF ||
+					    (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+					{
+						return { read, written, TranscodeStatus::Invalid };
+					}
+
+					if constexpr (sizeof(OutputCharType) == 2)
+					{
+						if (codePoint >= 0x10000)
+						{
+							codePoint -= 0x10000;
+							output[written++] =
+							    static_cast<OutputCharType>(0xD800 + (codePoint >> 10));
+							output[written++] =
+							    static_cast<OutputCharType>(0xDC00 + (codePoint & 0x3FF));
+						}
+						else
+						{
+							output[written++] = static_cast<OutputCharType>(codePoint);
+						}
+					}
+					else
+					{
+						output[written++] = static_cast<OutputCharType>(codePoint);
+					}
+
+					read += length;
+				}
+			}
+
+			return { read, written, TranscodeStatus::Done };
+		}
+
+		/// @brief  从 UTF-16 或 UTF-32 转换到 UTF-8，前者由 InputCharType 的大小决定
+		/// @remark 拒绝孤立的代理及超过 0x10FFFF 的码点，output 的长度不能小于 input 的长度的 3 倍（UTF-16）或
+		///         4 倍（UTF-32）
+		template <typename InputCharType>
+		TranscodeResult TranscodeToUtf8(std::span<const InputCharType> input,
+		                                char8_t* output) noexcept
+		{
+			const auto size = input.size();
+			const auto data = input.data();
+			std::size_t read{};
+			std::size_t written{};
+
+			while (read < size)
+			{
+				const auto asciiCount = NarrowAscii(data + read, size - read, output + written);
+				read += asciiCount;
+				written += asciiCount;
+
+				while (read < size && data[read] >= 0x80)
+				{
+					auto codePoint = static_cast<char32_t>(data[read]);
+					std::size_t length = 1;
+					if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+					{
+						if constexpr (sizeof(InputCharType) == 2)
+						{
+							if (codePoint >= 0xDC00)
+							{
+								return { read, written, TranscodeStatus::Invalid };
+							}
+
+							if (read + 1 >= size)
+							{
+								return { read, written, TranscodeStatus::Incomplete };
+							}
+
+							const auto low = static_cast<char32_t>(data[read + 1]);
+							if (low < 0xDC00 || low > 0xDFFF)
+							{
+								return { read, written, TranscodeStatus::Invalid };
+							}
+
+							codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+							length = 2;
+						}
+						else
+						{
+							return { read, written, TranscodeStatus::Invalid };
+						}
+					}
+					else if (codePoint > 0x10FFFF)
+					{
+						return { read, written, TranscodeStatus::Invalid };
+					}
+
+					if (codePoint < 0x800)
+					{
+						output[written++] = static_cast<char8_t>(0xC0 | (codePoint >> 6));
+						output[written++] = static_cast<char8_t>(0x80 | (codePoint & 0x3F));
+					}
+					else if (codePoint < 0x10000)
+					{
+						output[written++] = static_cast<char8_t>(0xE0 | (codePoint >> 12));
+						output[written++] = static_cast<char8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+						output[written++] = static_cast<char8_t>(0x80 | (codePoint & 0x3F));
+					}
+					else
+					{
+						output[written++] = static_cast<char8_t>(0xF0 | (codePoint >> 18));
+						output[written++] = static_cast<char8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+						output[written++] = static_cast<char8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+						output[written++] = static_cast<char8_t>(0x80 | (codePoint & 0x3F));
+					}
+
+					read += length;
+				}
+			}
+
+			return { read, written, TranscodeStatus::Done };
+		}
+
+		/// @brief  计算 UTF-8 序列转换到 UTF-16 或 UTF-32 后的长度，后者由 OutputCharSize 决定
+		/// @remark 仅统计非续字节及四字节序列的首字节，输入有效时结果准确
+		template <std::size_t OutputCharSize>
+		std::size_t GetLengthFromUtf8(std::span<const char8_t> input) noexcept
+		{
+			const auto size = input.size();
+			const auto data = input.data();
+			std::size_t i{};
+			std::size_t result{};
+#if CAFE_TEXTUTILS_HAS_SSE2
+			// 有符号比较下，续字节 0x80-0xBF 为 -128 到 -65，四字节序列的首字节 0xF0-0xF4 为 -16 到 -12
+			const auto continuationMax = _mm_set1_epi8(-65);
+			const auto fourByteLeadMin = _mm_set1_epi8(-17);
+			for (; i + 16 <= size; i += 16)
+			{
+				const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				result += std::popcount(static_cast<unsigned>(
+				    _mm_movemask_epi8(_mm_cmpgt_epi8(block, continuationMax))));
+				if constexpr (OutputCharSize == 2)
+				{
+					result += std::popcount(static_cast<unsigned>(
+					    _mm_movemask_epi8(_mm_cmpgt_epi8(block, fourByteLeadMin)) &
+					    _mm_movemask_epi8(block)));
+				}
+			}
+#endif
+			for (; i < size; ++i)
+			{
+				result += !IsUtf8Continuation(data[i]);
+				if constexpr (OutputCharSize == 2)
+				{
+					result += data[i] >= 0xF0;
+				}
+			}
+
+			return result;
+		}
+
+		/// @brief  计算 UTF-16 或 UTF-32 序列转换到 UTF-8 后的长度，前者由 InputCharType 的大小决定
+		/// @remark 代理对的两个编码单元各计 2 字节，输入有效时结果准确
+		template <typename InputCharType>
+		std::size_t GetUtf8Length(std::span<const InputCharType> input) noexcept
+		{
+			std::size_t result{};
+			for (const auto unit : input)
+			{
+				const auto value = static_cast<std::uint32_t>(unit);
+				if (value < 0x80)
+				{
+					result += 1;
+				}
+				else if (value < 0x800 ||
+				         (sizeof(InputCharType) == 2 && value >= 0xD800 && value <= 0xDFFF))
+				{
+					result += 2;
+				}
+				else
+				{
+					result += value < 0x10000 ? 3 : 4;
+				}
+			}
+
+			return result;
+		}
+
+		/// @brief  常用编码对之间不经逐码点回调的转换，未特化的编码对不可用
+		/// @remark MaxExpansion 为每个输入编码单元至多产生的输出编码单元数量，
+		///         GetLength 计算输入有效时转换结果的长度
+		template <Encoding::CodePage::CodePageType FromCodePage,
+		          Encoding::CodePage::CodePageType ToCodePage>
+		struct FastTranscoder;
+
+		template <Encoding::CodePage::CodePageType ToCodePage>
+		requires(ToCodePage == NativeUtf16 || ToCodePage == NativeUtf32 ||
+		         ToCodePage == Encoding::CodePage::CodePoint)
+		struct FastTranscoder<Encoding::CodePage::Utf8, ToCodePage>
+		{
+			using OutputCharType = typename Encoding::CodePage::CodePageTrait<ToCodePage>::CharType;
+
+			static constexpr std::size_t MaxExpansion = 1;
+
+			static TranscodeResult Transcode(std::span<const char8_t> input,
+			                                 OutputCharType* output) noexcept
+			{
+				return TranscodeFromUtf8(input, output);
+			}
+
+			static std::size_t GetLength(std::span<const char8_t> input) noexcept
+			{
+				return GetLengthFromUtf8<sizeof(OutputCharType)>(input);
+			}
+		};
+
+		template <Encoding::CodePage::CodePageType FromCodePage>
+		requires(FromCodePage == NativeUtf16 || FromCodePage == NativeUtf32 ||
+		         FromCodePage == Encoding::CodePage::CodePoint)
+		struct FastTranscoder<FromCodePage, Encoding::CodePage::Utf8>
+		{
+			using InputCharType =
+			    typename Encoding::CodePage::CodePageTrait<FromCodePage>::CharType;
+
+			static constexpr std::size_t MaxExpansion = FromCodePage == NativeUtf16 ? 3 : 4;
+
+			static TranscodeResult Transcode(std::span<const InputCharType> input,
+			                                 char8_t* output) noexcept
+			{
+				return TranscodeToUtf8(input, output);
+			}
+
+			static std::size_t GetLength(std::span<const InputCharType> input) noexcept
+			{
+				return GetUtf8Length(input);
+			}
+		};
+
+		template <Encoding::CodePage::CodePageType FromCodePage,
+		          Encoding::CodePage::CodePageType ToCodePage>
+		concept HasFastTranscoder = requires
+		{
+			FastTranscoder<FromCodePage, ToCodePage>::MaxExpansion;
+		};
+	} // namespace Detail
+} // namespace Cafe::TextUtils
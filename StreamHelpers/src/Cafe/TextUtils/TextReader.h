@@ -142,8 +142,41 @@ namespace Cafe::TextUtils
 
 		Encoding::String<CodePageValue> ReadLine()
 		{
-			Encoding::String<CodePageValue> result;
+			return ReadLineInto(Encoding::String<CodePageValue>{});
+		}
+
+		/// @brief  使用 allocator 分配结果的 ReadLine，allocator 将被 rebind 到编码单元类型
+		template <Detail::AllocatorType Allocator>
+		Detail::StringWithAllocator<CodePageValue, Allocator> ReadLine(Allocator const& allocator)
+		{
+			return ReadLineInto(Detail::MakeStringWithAllocator<CodePageValue>(allocator));
+		}
+
+		Encoding::String<CodePageValue> ReadUntil(Encoding::CodePointType endingCodePoint)
+		{
+			return ReadUntilInto(endingCodePoint, Encoding::String<CodePageValue>{});
+		}
+
+		/// @brief  使用 allocator 分配结果的 ReadUntil，allocator 将被 rebind 到编码单元类型
+		template <Detail::AllocatorType Allocator>
+		Detail::StringWithAllocator<CodePageValue, Allocator>
+		ReadUntil(Encoding::CodePointType endingCodePoint, Allocator const& allocator)
+		{
+			return ReadUntilInto(endingCodePoint,
+			                     Detail::MakeStringWithAllocator<CodePageValue>(allocator));
+		}
+
+		Io::BufferedInputStream* GetStream() noexcept
+		{
+			return &m_Stream;
+		}
+
+	private:
+		Io::BufferedInputStream m_Stream;
 
+		template <typename StringType>
+		StringType ReadLineInto(StringType result)
+		{
 			while (const auto readCodePoint = Read())
 			{
 				const auto [codeUnits, codePoint] = *readCodePoint;
@@ -182,10 +215,9 @@ namespace Cafe::TextUtils
 			return result;
 		}
 
-		Encoding::String<CodePageValue> ReadUntil(Encoding::CodePointType endingCodePoint)
+		template <typename StringType>
+		StringType ReadUntilInto(Encoding::CodePointType endingCodePoint, StringType result)
 		{
-			Encoding::String<CodePageValue> result;
-
 			while (const auto readCodePoint = Read())
 			{
 				const auto [codeUnits, codePoint] = *readCodePoint;
@@ -199,13 +231,5 @@ namespace Cafe::TextUtils
 
 			return result;
 		}
-
-		Io::BufferedInputStream* GetStream() noexcept
-		{
-			return &m_Stream;
-		}
-
-	private:
-		Io::BufferedInputStream m_Stream;
 	};
 } // namespace Cafe::TextUtils
@@ -7,6 +7,47 @@
 
 namespace Cafe::TextUtils
 {
+	/// @brief  写入缓冲流的 OutputSink，结果不经中间字符串直接交给缓冲流
+	/// @remark 本类不取得流的所有权
+	template <Encoding::CodePage::CodePageType CodePageValue>
+	class StreamSink
+	    : public Detail::OutputSinkCallOperator<StreamSink<CodePageValue>, CodePageValue>
+	{
+	public:
+		static constexpr Encoding::CodePage::CodePageType UsingCodePage = CodePageValue;
+		using CharType = typename Encoding::CodePage::CodePageTrait<CodePageValue>::CharType;
+
+		explicit StreamSink(Io::BufferedOutputStream* stream) noexcept : m_Stream{ stream }
+		{
+		}
+
+		std::span<CharType> Reserve(std::size_t size)
+		{
+			return m_Buffer.Get(size);
+		}
+
+		void Commit(std::size_t size)
+		{
+			Append(m_Buffer.Committed(size));
+		}
+
+		void Append(std::span<const CharType> units)
+		{
+			m_WrittenBytes += m_Stream->WriteBytes(std::as_bytes(units));
+		}
+
+		/// @brief  获得已写入的字节数
+		std::size_t GetWrittenBytes() const noexcept
+		{
+			return m_WrittenBytes;
+		}
+
+	private:
+		Io::BufferedOutputStream* m_Stream;
+		std::size_t m_WrittenBytes{};
+		Detail::SinkStagingBuffer<CodePageValue> m_Buffer;
+	};
+
 	/// @brief  文本写入类
 	/// @remark 与常见的设计不同，本类不取得包装的流的所有权，
 	///         因此必须由用户手动管理并保证包装的流的生命期在文本写入类的生命期全程都有效
@@ -26,6 +67,10 @@ namespace Cafe::TextUtils
 			m_Stream.Flush();
 		}
 
+		/// @brief  格式化 format 并写入流
+		/// @remark 结果直接写入缓冲流，格式化中途抛出异常时，已产生的部分结果已写入缓冲流且不会撤销，
+		///         需要保证不写入不完整的结果时应先使用 FormatString 得到完整的结果再写入
+		/// @return 写入的字节数
 		template <typename... Args>
 		std::size_t Write(Encoding::StringView<CodePageValue> const& format, Args const&... args)
 		{
@@ -35,8 +80,10 @@ namespace Cafe::TextUtils
 			}
 			else
 			{
-				const auto tmpStr = FormatString(format, args...);
-				return m_Stream.WriteBytes(std::as_bytes(tmpStr.GetView().GetTrimmedSpan()));
+				// 直接写入缓冲流，避免构造临时字符串
+				StreamSink<CodePageValue> sink{ &m_Stream };
+				FormatStringWithReceiver(sink, format, args...);
+				return sink.GetWrittenBytes();
 			}
 		}
 
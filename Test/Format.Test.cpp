@@ -1,22 +1,1052 @@
+#include <Cafe/TextUtils/ArenaAllocator.h>
 #include <Cafe/TextUtils/Format.h>
+#include <Cafe/TextUtils/FormatArgs.h>
+#include <Cafe/TextUtils/FormatBatch.h>
 #include <catch2/catch_all.hpp>
 
 using namespace Cafe;
 using namespace TextUtils;
 
+namespace
+{
+	std::size_t AllocationCount;
+
+	template <typename T>
+	struct CountingAllocator
+	{
+		using value_type = T;
+
+		CountingAllocator() = default;
+
+		template <typename U>
+		CountingAllocator(CountingAllocator<U> const&) noexcept
+		{
+		}
+
+		T* allocate(std::size_t n)
+		{
+			++AllocationCount;
+			return std::allocator<T>{}.allocate(n);
+		}
+
+		void deallocate(T* p, std::size_t n) noexcept
+		{
+			std::allocator<T>{}.deallocate(p, n);
+		}
+
+		template <typename U>
+		bool operator==(CountingAllocator<U> const&) const noexcept
+		{
+			return true;
+		}
+	};
+
+	template <typename StringType>
+	struct StringParameters;
+
+	template <Encoding::CodePage::CodePageType CodePageValue, typename Allocator,
+	          std::size_t SsoThresholdSizeValue, typename GrowPolicyType>
+	struct StringParameters<
+	    Encoding::String<CodePageValue, Allocator, SsoThresholdSizeValue, GrowPolicyType>>
+	{
+		static constexpr std::size_t SsoThresholdSize = SsoThresholdSizeValue;
+		using GrowPolicy = GrowPolicyType;
+	};
+
+	using CountingCharAllocator =
+	    CountingAllocator<Encoding::CodePage::CodePageTrait<Encoding::CodePage::Utf8>::CharType>;
+	using CountingString = Encoding::String<Encoding::CodePage::Utf8, CountingCharAllocator>;
+	using CountingStringParameters = StringParameters<CountingString>;
+
+	// 不预留空间的格式化，即预留空间前的做法，作为比较的基准
+	template <typename Format, typename... Args>
+	CountingString FormatWithoutReserve(Format const& format, Args const&... args)
+	{
+		CountingString resultStr;
+		FormatStringWithReceiver([&](auto const& result) { resultStr.Append(result); }, format,
+		                         args...);
+		return resultStr;
+	}
+
+	template <typename Format, typename... Args>
+	CountingString FormatWithReserve(Format const& format, Args const&... args)
+	{
+		return FormatCustomString<CountingCharAllocator, CountingStringParameters::SsoThresholdSize,
+		                          CountingStringParameters::GrowPolicy>(format, args...);
+	}
+
+	template <typename Function>
+	std::size_t CountAllocations(Function&& function)
+	{
+		const auto prevCount = AllocationCount;
+		function();
+		return AllocationCount - prevCount;
+	}
+
+	template <Encoding::CodePage::CodePageType CodePageValue, typename CharType, std::size_t N>
+	constexpr Encoding::StringView<CodePageValue, N> MakeView(const CharType (&str)[N]) noexcept
+	{
+		return Encoding::StringView<CodePageValue, N>{ std::span<const CharType, N>(str) };
+	}
+	// 直接写入定长缓冲区的 OutputSink
+	struct FixedBufferSink
+	{
+		static constexpr auto UsingCodePage = Encoding::CodePage::Utf8;
+
+		std::array<char8_t, 64> Buffer{};
+		std::size_t Size{};
+		std::size_t ReserveCount{};
+
+		std::span<char8_t> Reserve(std::size_t size)
+		{
+			++ReserveCount;
+			return std::span(Buffer).subspan(Size, size);
+		}
+
+		void Commit(std::size_t size)
+		{
+			Size += size;
+		}
+
+		void Append(std::span<const char8_t> units)
+		{
+			std::copy(units.begin(), units.end(), Buffer.begin() + Size);
+			Size += units.size();
+		}
+
+		Encoding::StringView<Encoding::CodePage::Utf8> GetView() const
+		{
+			return std::span<const char8_t>(Buffer.data(), Size);
+		}
+	};
+
+	// 记录 ASCII 结果是否经过 Reserve 的 UTF-16 OutputSink
+	struct AsciiRecordingSink
+	{
+		static constexpr auto UsingCodePage = Encoding::CodePage::Utf16LittleEndian;
+
+		Encoding::String<Encoding::CodePage::Utf16LittleEndian> Result;
+		std::size_t ReserveCount{};
+		std::size_t AppendAsciiCount{};
+
+		std::span<char16_t> Reserve(std::size_t size)
+		{
+			++ReserveCount;
+			m_Buffer.resize(size);
+			return m_Buffer;
+		}
+
+		void Commit(std::size_t size)
+		{
+			Append(std::span<const char16_t>(m_Buffer.data(), size));
+		}
+
+		void Append(std::span<const char16_t> units)
+		{
+			Result.Append(units);
+		}
+
+		void AppendAscii(std::span<const char> chars)
+		{
+			++AppendAsciiCount;
+			for (const auto c : chars)
+			{
+				Result.Append(static_cast<char16_t>(c));
+			}
+		}
+
+	private:
+		std::vector<char16_t> m_Buffer;
+	};
+
+	// 以单个编码单元调用接收器的转换器
+	struct BracketStringConverter
+	{
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		void ToString(T const& value, Encoding::StringView<CodePageValue> const& formatOption,
+		              Output&& output)
+		{
+			output(u8'[');
+			DefaultStringConverter::ToString(value, formatOption, output);
+			output(u8']');
+		}
+	};
+
+	// 记录收到预先分析的格式化选项次数的转换器
+	struct PreparedOptionStringConverter
+	{
+		std::size_t PreparedCount = 0;
+
+		template <typename T, Encoding::CodePage::CodePageType CodePageValue, typename Output>
+		FormatErrorCode ToString(T const& value,
+		                         PreparedFormatOption<CodePageValue> const& formatOption,
+		                         Output&& output)
+		{
+			++PreparedCount;
+			return DefaultStringConverter::ToString(value, formatOption, output);
+		}
+	};
+} // namespace
+
+namespace UserTypes
+{
+	struct Point
+	{
+		int X;
+		int Y;
+	};
+
+	template <OutputSink Sink>
+	void FormatValue(Point const& value,
+	                 Encoding::StringView<Encoding::CodePage::Utf8> const& formatOption, Sink& sink)
+	{
+		sink.Append(CAFE_UTF8_SV("(").GetTrimmedSpan());
+		DefaultStringConverter::ToString(value.X, formatOption, sink);
+		sink.Append(CAFE_UTF8_SV(", ").GetTrimmedSpan());
+		DefaultStringConverter::ToString(value.Y, formatOption, sink);
+		sink.Append(CAFE_UTF8_SV(")").GetTrimmedSpan());
+	}
+} // namespace UserTypes
+
 TEST_CASE("Cafe.TextUtils.Format", "[TextUtils][Format]")
 {
 	SECTION("Formatting with index")
 	{
 		const auto formattedString =
 		    FormatString(CAFE_UTF8_SV("${0}, ${1}, ${3:x}, ${2}, $$"), 1, 2.5f, -3, 18);
-		REQUIRE(formattedString == CAFE_UTF8_SV("1, 2.50000, 12, -3, $"));
+		REQUIRE(formattedString == CAFE_UTF8_SV("1, 2.5, 12, -3, $"));
 	}
 
 	SECTION("Formatting without index")
 	{
 		const auto formattedString =
 		    FormatString(CAFE_UTF8_SV("${}, ${}, ${:x}, ${}, $$"), 1, 2.5f, 18, -3);
-		REQUIRE(formattedString == CAFE_UTF8_SV("1, 2.50000, 12, -3, $"));
+		REQUIRE(formattedString == CAFE_UTF8_SV("1, 2.5, 12, -3, $"));
+	}
+
+	SECTION("Formatting with compiled format")
+	{
+		const auto formattedString = FormatString(
+		    CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${0}, ${1}, ${3:x}, ${2}, $$")), 1, 2.5f, -3, 18);
+		REQUIRE(formattedString == CAFE_UTF8_SV("1, 2.5, 12, -3, $"));
+
+		constexpr auto compiledFormat = CompileFormat<CountFormatSegments(
+		    CAFE_UTF8_SV("${}${:X}!"))>(CAFE_UTF8_SV("${}${:X}!"));
+		STATIC_REQUIRE(compiledFormat.GetSegments().size() == 3);
+		REQUIRE(FormatString(compiledFormat, 1, 255) == CAFE_UTF8_SV("1FF!"));
+
+		// 格式化选项在编译格式串时已经分析
+		constexpr auto preparedOption = compiledFormat.GetSegments()[1].PreparedOption;
+		STATIC_REQUIRE(preparedOption.Integer.has_value());
+		STATIC_REQUIRE(preparedOption.Integer->Base == 16);
+		STATIC_REQUIRE(preparedOption.Integer->UseUppercase);
+		STATIC_REQUIRE(!preparedOption.Floating.has_value());
+
+		PreparedOptionStringConverter converter;
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		FormatStringWithCustomConverter(
+		    [&](auto const& units) { result.Append(units); }, converter,
+		    CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${:x}, ${:f.2}, ${:b}")), 255, 0.125, 5);
+		REQUIRE(result == CAFE_UTF8_SV("ff, 0.12, 101"));
+		REQUIRE(converter.PreparedCount == 3);
+	}
+
+	SECTION("Formatting with runtime template")
+	{
+		const auto formatText = EncodeFromNarrow<Encoding::CodePage::Utf8>("${}: ${:x}$$");
+		const FormatTemplate formatTemplate{ formatText.GetView() };
+		REQUIRE(formatTemplate.GetArgumentCount() == 2);
+		// 格式化选项在构造时已经分析
+		const auto& preparedOption = formatTemplate.GetSegments()[2].PreparedOption;
+		REQUIRE(preparedOption.Integer.has_value());
+		REQUIRE(preparedOption.Integer->Base == 16);
+		REQUIRE_NOTHROW((formatTemplate.Check<DefaultStringConverter, int, int>()));
+		CHECK_THROWS_AS((formatTemplate.Check<DefaultStringConverter, int>()), FormatException);
+		CHECK_THROWS_AS((formatTemplate.Check<DefaultStringConverter, int, float>()),
+		                FormatException);
+		CHECK_THROWS_AS((formatTemplate.Check<CharsStringConverter, int, float>()),
+		                FormatException);
+		// 不提供 CheckFormatOption 的转换器不检查格式化选项
+		REQUIRE_NOTHROW((formatTemplate.Check<BracketStringConverter, int, float>()));
+
+		REQUIRE(FormatString(formatTemplate, 1, 255) == CAFE_UTF8_SV("1: ff$"));
+		REQUIRE(FormatString(formatTemplate, -1, 16) == CAFE_UTF8_SV("-1: 10$"));
+
+		PreparedOptionStringConverter converter;
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		FormatStringWithCustomConverter([&](auto const& units) { result.Append(units); },
+		                                converter, formatTemplate, 2, 10);
+		REQUIRE(result == CAFE_UTF8_SV("2: a$"));
+		REQUIRE(converter.PreparedCount == 2);
+		CHECK_THROWS_AS(FormatTemplate{ CAFE_UTF8_SV("${0}${}") }, FormatException);
+	}
+
+	SECTION("Formatting with allocator")
+	{
+		alignas(std::max_align_t) std::byte buffer[256];
+		Arena arena{ buffer };
+		const auto formattedString =
+		    FormatString(std::allocator_arg, ArenaAllocator<std::byte>{ arena },
+		                 CAFE_UTF8_SV("${0}, ${1}, ${3:x}, ${2}, $$"), 1, 2.5f, -3, 18);
+		REQUIRE(formattedString.GetView() == CAFE_UTF8_SV("1, 2.5, 12, -3, $"));
+
+		const auto compiledString =
+		    FormatString(std::allocator_arg, ArenaAllocator<std::byte>{ arena },
+		                 CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}${:X}!")), 1, 255);
+		REQUIRE(compiledString.GetView() == CAFE_UTF8_SV("1FF!"));
+		// 预估大小足够时不会超出用户提供的缓冲区
+		CHECK(arena.GetChunkCount() == 0);
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format integer", "[TextUtils][Format]")
+{
+	SECTION("Bases and limits")
+	{
+		REQUIRE(FormatString(CAFE_UTF8_SV("${}"), std::numeric_limits<std::int64_t>::min()) ==
+		        CAFE_UTF8_SV("-9223372036854775808"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${}"), std::numeric_limits<std::uint64_t>::max()) ==
+		        CAFE_UTF8_SV("18446744073709551615"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${:x}"), std::numeric_limits<std::int8_t>::min()) ==
+		        CAFE_UTF8_SV("-80"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${:b} ${:o} ${:X} ${:d}"), 5, 8, 0xBEEF, 0) ==
+		        CAFE_UTF8_SV("101 10 BEEF 0"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${} ${} ${}"), 9, 10, 100) ==
+		        CAFE_UTF8_SV("9 10 100"));
+	}
+
+	SECTION("Digit count")
+	{
+		std::uintmax_t value{ 1 };
+		for (std::size_t digitCount = 1; digitCount <= 19; ++digitCount, value *= 10)
+		{
+			CHECK(Detail::CountDigits(value - 1, 10) == std::max(digitCount - 1, std::size_t{ 1 }));
+			CHECK(Detail::CountDigits(value, 10) == digitCount);
+		}
+		CHECK(Detail::CountDigits(0xFF, 16) == 2);
+		CHECK(Detail::CountDigits(0x100, 16) == 3);
+		CHECK(Detail::CountDigits(7, 8) == 1);
+		CHECK(Detail::CountDigits(8, 2) == 4);
+	}
+
+	SECTION("Compile time")
+	{
+		constexpr auto result = [] {
+			std::array<char8_t, Detail::MaxIntegerLength> buffer{};
+			std::size_t size{};
+			DefaultStringConverter::ToString(std::numeric_limits<std::int32_t>::min(),
+			                                 Encoding::StringView<Encoding::CodePage::Utf8>{},
+			                                 [&](auto const& span) {
+				                                 for (const auto item : span)
+				                                 {
+					                                 buffer[size++] = item;
+				                                 }
+			                                 });
+			return std::pair{ buffer, size };
+		}();
+		STATIC_REQUIRE(result.second == 11);
+		STATIC_REQUIRE(result.first[0] == u8'-' && result.first[10] == u8'8');
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format floating", "[TextUtils][Format]")
+{
+	SECTION("Shortest round trip")
+	{
+		REQUIRE(FormatString(CAFE_UTF8_SV("${} ${} ${}"), 0.1, 0.1f, 1.0 / 3) ==
+		        CAFE_UTF8_SV("0.1 0.1 0.3333333333333333"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${} ${} ${}"), 1e300, -0.0, 123456.5) ==
+		        CAFE_UTF8_SV("1e+300 -0 123456.5"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${} ${}"), std::numeric_limits<double>::max(),
+		                     std::numeric_limits<double>::denorm_min()) ==
+		        CAFE_UTF8_SV("1.7976931348623157e+308 5e-324"));
+	}
+
+	SECTION("Options")
+	{
+		REQUIRE(FormatString(CAFE_UTF8_SV("${:f.2} ${:f} ${:e} ${:e.3} ${:g.3}"), 3.14159, 2.5,
+		                     1234.5, 1234.5, 0.000012345) ==
+		        CAFE_UTF8_SV("3.14 2.5 1.2345e+03 1.234e+03 1.23e-05"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${:f.0}"), 1e20) ==
+		        CAFE_UTF8_SV("100000000000000000000"));
+		CHECK_THROWS_AS(FormatString(CAFE_UTF8_SV("${:x}"), 1.0), FormatException);
+		CHECK_THROWS_AS(FormatString(CAFE_UTF8_SV("${:f.}"), 1.0), FormatException);
+		CHECK_THROWS_AS(FormatString(CAFE_UTF8_SV("${:f.1000}"), 1.0), FormatException);
+	}
+
+	SECTION("Special values")
+	{
+		REQUIRE(FormatString(CAFE_UTF8_SV("${} ${} ${}"), std::numeric_limits<double>::quiet_NaN(),
+		                     std::numeric_limits<double>::infinity(),
+		                     -std::numeric_limits<float>::infinity()) ==
+		        CAFE_UTF8_SV("NaN Infinity -Infinity"));
+	}
+
+	SECTION("Size hint is an upper bound")
+	{
+		constexpr auto format = CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${:f}|${:f.3}|${:e}|${:g}|${}"));
+		for (const auto value : { 0.0, 1e-300, 5e-324, 0.1, 123.456, 1e308, -1.5e100 })
+		{
+			const auto sizeHint =
+			    Detail::GetFormatSizeHint(DefaultStringConverter{}, format, value, value, value,
+			                              value, value);
+			CHECK(FormatStringSize(format, value, value, value, value, value) <= sizeHint.Size);
+		}
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format size hint", "[TextUtils][Format]")
+{
+	constexpr auto format = CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}|${:x}|${:b}|${}"));
+	const auto str = CAFE_UTF8_SV("text");
+
+	const auto sizeHint = Detail::GetFormatSizeHint(DefaultStringConverter{}, format,
+	                                                std::numeric_limits<std::int64_t>::min(),
+	                                                255u, 5, str);
+	REQUIRE(sizeHint.IsExact);
+	REQUIRE(sizeHint.Size == 20 + 2 + 3 + 4 + 3);
+	REQUIRE(FormatStringSize(format, std::numeric_limits<std::int64_t>::min(), 255u, 5, str) ==
+	        sizeHint.Size);
+
+	const auto formattedString = FormatWithReserve(format, -1, 255u, 5, str);
+	REQUIRE(formattedString == CAFE_UTF8_SV("-1|ff|101|text"));
+	REQUIRE(CountAllocations([&] { FormatWithReserve(format, 1, 2u, 3, str); }) <=
+	        CountAllocations([&] { FormatWithoutReserve(format, 1, 2u, 3, str); }));
+}
+
+TEST_CASE("Cafe.TextUtils.Format AsciiToNumber", "[TextUtils][Format]")
+{
+	SECTION("Long digit runs")
+	{
+		const auto [value, count, overflowed] =
+		    AsciiToNumberWithOverflow(CAFE_UTF8_SV("12345678901234567890x"));
+		REQUIRE(value == 12345678901234567890u);
+		REQUIRE(count == 20);
+		REQUIRE(!overflowed);
+
+		const auto [value16, count16] =
+		    AsciiToNumber(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"1234567890123456789"));
+		REQUIRE(value16 == 1234567890123456789u);
+		REQUIRE(count16 == 19);
+
+		const auto result32 = AsciiToNumberWithOverflow(
+		    MakeView<Encoding::CodePage::Utf32LittleEndian>(U"0012345678}"));
+		REQUIRE(result32.Value == 12345678);
+		REQUIRE(result32.Size == 10);
+		REQUIRE(!result32.IsOverflow);
+	}
+
+	SECTION("Early stop")
+	{
+		const auto [value, count] = AsciiToNumber(CAFE_UTF8_SV("1234567:9"));
+		REQUIRE(value == 1234567);
+		REQUIRE(count == 7);
+
+		const auto result16 =
+		    AsciiToNumber(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"1234\u0130567"));
+		REQUIRE(result16.first == 1234);
+		REQUIRE(result16.second == 4);
+	}
+
+	SECTION("Overflow")
+	{
+		const auto [value, count, overflowed] =
+		    AsciiToNumberWithOverflow(CAFE_UTF8_SV("18446744073709551616"));
+		REQUIRE(overflowed);
+		REQUIRE(value == std::numeric_limits<std::uintmax_t>::max());
+		REQUIRE(count == 20);
+		REQUIRE(AsciiToNumber(CAFE_UTF8_SV("18446744073709551616")) ==
+		        std::pair{ std::numeric_limits<std::uintmax_t>::max(), std::size_t{ 20 } });
+
+		REQUIRE(!AsciiToNumberWithOverflow(CAFE_UTF8_SV("18446744073709551615")).IsOverflow);
+		CHECK_THROWS_AS(FormatString(CAFE_UTF8_SV("${18446744073709551616}"), 1), FormatException);
+	}
+
+	SECTION("Other bases")
+	{
+		REQUIRE(AsciiToNumber(CAFE_UTF8_SV("ffFF"), 16).first == 0xFFFF);
+		REQUIRE(AsciiToNumber(CAFE_UTF8_SV("101012"), 2).first == 0b10101);
+		REQUIRE(AsciiToNumber(CAFE_UTF8_SV("zz"), 36).first == 36 * 36 - 1);
+	}
+
+	SECTION("Compile time")
+	{
+		STATIC_REQUIRE(AsciiToNumber(CAFE_UTF8_SV("1234567890123")).first == 1234567890123u);
+		STATIC_REQUIRE(
+		    AsciiToNumberWithOverflow(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"12345678a"))
+		        .Size == 8);
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format ParseNumber", "[TextUtils][Format]")
+{
+	SECTION("Integers")
+	{
+		const auto result = ParseNumber<int>(CAFE_UTF8_SV("-123abc"));
+		REQUIRE(result.ResultCode == ParseNumberResultCode::Success);
+		REQUIRE(result.Result == -123);
+		REQUIRE(result.AdvanceCount == 4);
+
+		REQUIRE(ParseNumber<std::int8_t>(CAFE_UTF8_SV("-128")).Result == -128);
+		REQUIRE(ParseNumber<std::int64_t>(CAFE_UTF8_SV("-9223372036854775808")).Result ==
+		        std::numeric_limits<std::int64_t>::min());
+		REQUIRE(ParseNumber<unsigned>(CAFE_UTF8_SV("ff"), 16).Result == 0xFF);
+		REQUIRE(ParseNumber<int>(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"-42"))
+		            .Result == -42);
+
+		STATIC_REQUIRE(ParseNumber<short>(CAFE_UTF8_SV("-32768")).Result == -32768);
+	}
+
+	SECTION("Integer errors")
+	{
+		REQUIRE(ParseNumber<int>(CAFE_UTF8_SV("abc")).ResultCode ==
+		        ParseNumberResultCode::Invalid);
+		REQUIRE(ParseNumber<int>(CAFE_UTF8_SV("-")).ResultCode == ParseNumberResultCode::Invalid);
+		REQUIRE(ParseNumber<unsigned>(CAFE_UTF8_SV("-1")).ResultCode ==
+		        ParseNumberResultCode::Invalid);
+
+		const auto overflowed = ParseNumber<std::int8_t>(CAFE_UTF8_SV("-129"));
+		REQUIRE(overflowed.ResultCode == ParseNumberResultCode::Overflow);
+		REQUIRE(overflowed.Result == -128);
+		REQUIRE(overflowed.AdvanceCount == 4);
+		REQUIRE(ParseNumber<std::uint64_t>(CAFE_UTF8_SV("18446744073709551616")).ResultCode ==
+		        ParseNumberResultCode::Overflow);
+	}
+
+	SECTION("Floating")
+	{
+		const auto result = ParseNumber<double>(CAFE_UTF8_SV("-1.5e3,"));
+		REQUIRE(result.ResultCode == ParseNumberResultCode::Success);
+		REQUIRE(result.Result == -1500.0);
+		REQUIRE(result.AdvanceCount == 6);
+
+		REQUIRE(ParseNumber<double>(CAFE_UTF8_SV("0.1")).Result == 0.1);
+		REQUIRE(ParseNumber<float>(CAFE_UTF8_SV("0.1")).Result == 0.1f);
+		REQUIRE(ParseNumber<double>(CAFE_UTF8_SV("Infinity")).Result ==
+		        std::numeric_limits<double>::infinity());
+		REQUIRE(std::isnan(ParseNumber<double>(CAFE_UTF8_SV("NaN")).Result));
+
+		const auto utf16Result =
+		    ParseNumber<double>(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"2.5e-3\u4E2D"));
+		REQUIRE(utf16Result.Result == 2.5e-3);
+		REQUIRE(utf16Result.AdvanceCount == 6);
+	}
+
+	SECTION("Floating round trip")
+	{
+		for (const auto value : { 0.1, 1.0 / 3, 5e-324, 1.7976931348623157e308, -123456.789 })
+		{
+			const auto str = FormatString(CAFE_UTF8_SV("${}"), value);
+			REQUIRE(ParseNumber<double>(str.GetView()).Result == value);
+		}
+	}
+
+	SECTION("Floating errors")
+	{
+		REQUIRE(ParseNumber<double>(CAFE_UTF8_SV("x1")).ResultCode ==
+		        ParseNumberResultCode::Invalid);
+		const auto overflowed = ParseNumber<double>(CAFE_UTF8_SV("-1e400"));
+		REQUIRE(overflowed.ResultCode == ParseNumberResultCode::Overflow);
+		REQUIRE(overflowed.Result == -std::numeric_limits<double>::infinity());
+
+		const auto underflowed = ParseNumber<double>(CAFE_UTF8_SV("1e-400"));
+		REQUIRE(underflowed.ResultCode == ParseNumberResultCode::Underflow);
+		REQUIRE(underflowed.Result == 0.0);
+		REQUIRE(!std::signbit(underflowed.Result));
+		REQUIRE(underflowed.AdvanceCount == 6);
+
+		const auto negativeUnderflowed =
+		    ParseNumber<double>(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"-0.0001e-400"));
+		REQUIRE(negativeUnderflowed.ResultCode == ParseNumberResultCode::Underflow);
+		REQUIRE(negativeUnderflowed.Result == 0.0);
+		REQUIRE(std::signbit(negativeUnderflowed.Result));
+
+		REQUIRE(ParseNumber<float>(CAFE_UTF8_SV("1000e-50")).ResultCode ==
+		        ParseNumberResultCode::Underflow);
+		REQUIRE(ParseNumber<float>(CAFE_UTF8_SV("0.001e42")).ResultCode ==
+		        ParseNumberResultCode::Overflow);
+
+		// 非 UTF-8 的输入仅复制到定长的缓冲区
+		const auto parseUtf16 = [](std::u16string const& str) {
+			return ParseNumber<double>(Encoding::StringView<Encoding::CodePage::Utf16LittleEndian>{
+			    std::span<const char16_t>(str) });
+		};
+		const auto maxFixed = u"1" + std::u16string(308, u'0');
+		REQUIRE(parseUtf16(maxFixed).Result == 1e308);
+		REQUIRE(parseUtf16(maxFixed + u"-" + std::u16string(400, u'x')).AdvanceCount == 309);
+		REQUIRE(parseUtf16(u"1" + std::u16string(400, u'0')).ResultCode ==
+		        ParseNumberResultCode::Invalid);
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format literal scanning", "[TextUtils][Format]")
+{
+	SECTION("FindAsciiUnit")
+	{
+		const auto check = [](auto fill) {
+			using CharType = decltype(fill);
+			std::vector<CharType> units(70, fill);
+			REQUIRE(Detail::FindAsciiUnit(std::span<const CharType>(units), '$') == units.size());
+			for (std::size_t i = 0; i < units.size(); ++i)
+			{
+				units[i] = '$';
+				CHECK(Detail::FindAsciiUnit(std::span<const CharType>(units), '$') == i);
+				units[i] = fill;
+			}
+		};
+		check(char8_t{ 'a' });
+		// 高位字节与 '$' 相同的编码单元不能被误认
+		check(char16_t{ 0x2424 });
+		check(char32_t{ 0x10024 });
+	}
+
+	SECTION("Long literals")
+	{
+		constexpr auto html =
+		    CAFE_UTF8_SV("<div class=\"report\">\u4E2D\u6587 long literal text ${}</div>$$");
+		REQUIRE(FormatString(html, 42) ==
+		        CAFE_UTF8_SV("<div class=\"report\">\u4E2D\u6587 long literal text 42</div>$"));
+		constexpr auto format = CAFE_COMPILE_FORMAT(
+		    CAFE_UTF8_SV("a long literal run that is scanned at compile time ${} and more text"));
+		REQUIRE(FormatString(format, 1) ==
+		        CAFE_UTF8_SV("a long literal run that is scanned at compile time 1 and more text"));
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format output sink", "[TextUtils][Format]")
+{
+	SECTION("Direct writes")
+	{
+		FixedBufferSink sink;
+		FormatStringWithReceiver(sink, CAFE_UTF8_SV("${}|${:x}|${:f.1}|${}"), -42, 255, 2.25,
+		                         CAFE_UTF8_SV("str"));
+		REQUIRE(sink.GetView() == CAFE_UTF8_SV("-42|ff|2.2|str").Trim());
+		// 仅数值经过 Reserve，字面文本与字符串直接追加
+		REQUIRE(sink.ReserveCount == 3);
+	}
+
+	SECTION("String sink")
+	{
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		result.Append(CAFE_UTF8_SV("ab"));
+		StringSink sink{ result };
+		const auto buffer = sink.Reserve(8);
+		if constexpr (Detail::ResizableString<decltype(result), char8_t>)
+		{
+			// 直接写入字符串的剩余空间
+			REQUIRE(buffer.data() == result.GetData() + 2);
+		}
+		buffer[0] = u8'c';
+		sink.Commit(1);
+		REQUIRE(result == CAFE_UTF8_SV("abc"));
+
+		FormatStringWithReceiver(sink, CAFE_UTF8_SV("${}${:e}"), -1234567, 0.5);
+		REQUIRE(result == CAFE_UTF8_SV("abc-12345675e-01"));
+	}
+
+	SECTION("Receivers and converters of the former protocol")
+	{
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		FormatStringWithCustomConverter(
+		    [&](auto const& units) { result.Append(units); }, BracketStringConverter{},
+		    CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}, ${:X}")), 1.5, 0xAB);
+		REQUIRE(result == CAFE_UTF8_SV("[1.5], [AB]"));
+	}
+
+	SECTION("Size counting")
+	{
+		REQUIRE(FormatStringSize(CAFE_UTF8_SV("${}, ${}"), 1.5, -10) == 8);
+		REQUIRE(FormatStringSize(CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}, ${}")), 1.5, -10) == 8);
+		STATIC_REQUIRE(FormatStringSize(CAFE_UTF8_SV("${:b}$$"), 5u) == 4);
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format FormatTo", "[TextUtils][Format]")
+{
+	SECTION("Enough space")
+	{
+		std::array<char8_t, 32> buffer{};
+		const auto result = FormatTo(buffer, CAFE_UTF8_SV("${}: ${:x}"), -1, 255);
+		REQUIRE(!result.IsTruncated());
+		REQUIRE(result.WrittenSize == 6);
+		REQUIRE(Encoding::StringView<Encoding::CodePage::Utf8>{ std::span<const char8_t>(
+		            buffer.data(), result.WrittenSize) } == CAFE_UTF8_SV("-1: ff").Trim());
+		// 不写入结尾的空字符
+		REQUIRE(buffer[6] == 0);
+		REQUIRE(!FormatTo(std::span(buffer).first(6), CAFE_UTF8_SV("${}: ${:x}"), -1, 255)
+		             .IsTruncated());
+	}
+
+	SECTION("Truncation")
+	{
+		std::array<char8_t, 8> buffer{};
+		const auto result =
+		    FormatTo(buffer, CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}|${}")), 123456, 78901);
+		REQUIRE(result.IsTruncated());
+		REQUIRE(result.WrittenSize == 8);
+		REQUIRE(result.RequiredSize == 12);
+		REQUIRE(
+		    Encoding::StringView<Encoding::CodePage::Utf8>{ std::span<const char8_t>(buffer) } ==
+		    CAFE_UTF8_SV("123456|7").Trim());
+	}
+
+	SECTION("Never splits code points")
+	{
+		// “中”在 UTF-8 中占 3 个编码单元
+		std::array<char8_t, 5> buffer{};
+		const auto result = FormatTo(buffer, CAFE_UTF8_SV("a\u4E2D\u4E2D${}"), 1);
+		REQUIRE(result.WrittenSize == 4);
+		REQUIRE(result.RequiredSize == 8);
+
+		std::array<char16_t, 2> utf16Buffer{};
+		const auto utf16Result = FormatTo(
+		    utf16Buffer, MakeView<Encoding::CodePage::Utf16LittleEndian>(u"a\U0001F600${}"), 1);
+		REQUIRE(utf16Result.WrittenSize == 1);
+		REQUIRE(utf16Result.RequiredSize == 4);
+	}
+
+	SECTION("FormatToN")
+	{
+		char8_t buffer[4];
+		const auto result = FormatToN(buffer, 3, CAFE_UTF8_SV("${:f.2}"), 0.5);
+		REQUIRE(result.WrittenSize == 3);
+		REQUIRE(result.RequiredSize == 4);
+		REQUIRE((buffer[0] == u8'0' && buffer[1] == u8'.' && buffer[2] == u8'5'));
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format user types", "[TextUtils][Format]")
+{
+	const UserTypes::Point point{ 10, -255 };
+	REQUIRE(FormatString(CAFE_UTF8_SV("${} ${:x}"), point, point) ==
+	        CAFE_UTF8_SV("(10, -255) (a, -ff)"));
+	REQUIRE(FormatString(CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("p = ${}")), point) ==
+	        CAFE_UTF8_SV("p = (10, -255)"));
+	CHECK_THROWS_AS(FormatString(CAFE_UTF8_SV("${:q}"), point), FormatException);
+
+	STATIC_REQUIRE(Formattable<UserTypes::Point, Encoding::CodePage::Utf8>);
+	STATIC_REQUIRE(!Formattable<std::pair<int, int>, Encoding::CodePage::Utf8>);
+	STATIC_REQUIRE(!Formattable<std::vector<std::pair<int, int>>, Encoding::CodePage::Utf8>);
+}
+
+TEST_CASE("Cafe.TextUtils.Format CharsStringConverter", "[TextUtils][Format]")
+{
+	const auto formatWith = [](auto converter, auto const& format, auto const&... args) {
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		FormatStringWithCustomFormatter(StringSink{ result }, DefaultFormatter{}, converter,
+		                                format, args...);
+		return result;
+	};
+
+	SECTION("Same results as DefaultStringConverter")
+	{
+		const auto format = CAFE_UTF8_SV("${} ${:x} ${:X} ${:b} ${:o} ${} ${} ${:f.3} ${:e} ${}");
+		const auto check = [&](auto const&... args) {
+			REQUIRE(formatWith(CharsStringConverter{}, format, args...) ==
+			        formatWith(DefaultStringConverter{}, format, args...));
+		};
+		check(0, 255, 0xBEEFu, 5, 8, std::numeric_limits<std::int64_t>::min(),
+		      std::numeric_limits<std::uint64_t>::max(), 3.14159, 1234.5,
+		      CAFE_UTF8_SV("text"));
+		check(-1, -255, std::int8_t{ -128 }, 0, 0, true, 'a', -0.0, 5e-324, 0.1f);
+	}
+
+	SECTION("Other code pages")
+	{
+		Encoding::String<Encoding::CodePage::Utf16LittleEndian> result;
+		FormatStringWithCustomFormatter(StringSink{ result }, DefaultFormatter{},
+		                                CharsStringConverter{},
+		                                MakeView<Encoding::CodePage::Utf16LittleEndian>(u"${:X}"),
+		                                -0xABC);
+		REQUIRE(result == MakeView<Encoding::CodePage::Utf16LittleEndian>(u"-ABC"));
+	}
+
+	SECTION("Invalid options")
+	{
+		CHECK_THROWS_AS(formatWith(CharsStringConverter{}, CAFE_UTF8_SV("${:q}"), 1),
+		                FormatException);
+
+		// 不抛出异常的策略下返回错误码
+		using Converter = BasicCharsStringConverter<ReturnFormatErrorPolicy>;
+		STATIC_REQUIRE(noexcept(Converter::CheckFormatOption<int>(CAFE_UTF8_SV("q").Trim())));
+		REQUIRE(Converter::CheckFormatOption<int>(CAFE_UTF8_SV("q").Trim()) ==
+		        FormatErrorCode::InvalidOption);
+		REQUIRE(Converter::CheckFormatOption<double>(CAFE_UTF8_SV("f.999").Trim()) ==
+		        FormatErrorCode::PrecisionTooLarge);
+
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		REQUIRE(FormatStringWithCustomFormatter(StringSink{ result },
+		                                        BasicDefaultFormatter<ReturnFormatErrorPolicy>{},
+		                                        Converter{}, CAFE_UTF8_SV("${:x} ${:xb}"), 255,
+		                                        1) == FormatErrorCode::BaseRespecified);
+		REQUIRE(result == CAFE_UTF8_SV("ff "));
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format type-erased arguments", "[TextUtils][Format]")
+{
+	constexpr auto Utf8 = Encoding::CodePage::Utf8;
+	const UserTypes::Point point{ 1, 2 };
+	const auto str = EncodeFromNarrow<Utf8>("text");
+
+	SECTION("Same results as FormatString")
+	{
+		const auto format = CAFE_UTF8_SV("${} ${:x} ${} ${} ${:e} ${} ${} ${}, $$");
+		REQUIRE(VFormatString(format, MakeFormatArgs<Utf8>(-1, 255u, 0.1f, 0.1, 1234.5, str,
+		                                                   CAFE_UTF8_SV("view"), point)) ==
+		        FormatString(format, -1, 255u, 0.1f, 0.1, 1234.5, str, CAFE_UTF8_SV("view"),
+		                     point));
+
+		const FormatTemplate formatTemplate{ CAFE_UTF8_SV("${1}-${0:X}") };
+		REQUIRE(VFormatString(formatTemplate, MakeFormatArgs<Utf8>(std::uint8_t{ 0xAB }, true)) ==
+		        CAFE_UTF8_SV("1-AB"));
+	}
+
+	SECTION("Sinks")
+	{
+		std::array<char8_t, 4> buffer{};
+		SpanSink<Utf8> sink{ buffer };
+		VFormatTo(sink, CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}${}")), MakeFormatArgs<Utf8>(12, 345));
+		REQUIRE(sink.GetWrittenSize() == 4);
+		REQUIRE(sink.GetRequiredSize() == 5);
+	}
+
+	SECTION("Errors")
+	{
+		CHECK_THROWS_AS(VFormatString(CAFE_UTF8_SV("${1}"), MakeFormatArgs<Utf8>(1)),
+		                FormatException);
+		CHECK_THROWS_AS(VFormatString(CAFE_UTF8_SV("${:q}"), MakeFormatArgs<Utf8>(1)),
+		                FormatException);
+		REQUIRE(VFormatString(CAFE_UTF8_SV("none"), MakeFormatArgs<Utf8>()) ==
+		        CAFE_UTF8_SV("none"));
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format transcoding", "[TextUtils][Format]")
+{
+	SECTION("Same results as EncodeTo")
+	{
+		const auto format = CAFE_UTF8_SV("${}: ${:x}, ${:f.2} 测试𝄞 ${}");
+		const auto check = [&]<Encoding::CodePage::CodePageType ToCodePage>(auto const& format) {
+			const auto expected = EncodeTo<ToCodePage>(
+			    FormatString(format, -1, 255, 2.5, CAFE_UTF8_SV("文本")).GetView());
+			REQUIRE(FormatStringAs<ToCodePage>(format, -1, 255, 2.5, CAFE_UTF8_SV("文本")) ==
+			        expected);
+		};
+		check.operator()<Encoding::CodePage::Utf16LittleEndian>(format);
+		check.operator()<Encoding::CodePage::Utf32LittleEndian>(format);
+		check.operator()<Encoding::CodePage::Utf8>(format);
+		check.operator()<Encoding::CodePage::Utf16LittleEndian>(
+		    CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}: ${:x}, ${:f.2} 测试𝄞 ${}")));
+
+		// 没有快速转换内核的编码对，且非 ASCII 部分超过一次转换的缓冲区长度
+		Encoding::String<Encoding::CodePage::Utf16LittleEndian> longText;
+		for (std::size_t i = 0; i < 200; ++i)
+		{
+			longText.Append(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"测试𝄞 "));
+		}
+		REQUIRE(FormatStringAs<Encoding::CodePage::Utf32LittleEndian>(
+		            MakeView<Encoding::CodePage::Utf16LittleEndian>(u"${}: ${}"), -1,
+		            longText.GetView()) ==
+		        EncodeTo<Encoding::CodePage::Utf32LittleEndian>(
+		            FormatString(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"${}: ${}"), -1,
+		                         longText.GetView())
+		                .GetView()));
+	}
+
+	SECTION("Receivers")
+	{
+		std::size_t size{};
+		FormatStringWithReceiverAs<Encoding::CodePage::Utf32LittleEndian>(
+		    [&](std::span<const char32_t> units) { size += units.size(); }, CAFE_UTF8_SV("测试${}"),
+		    100);
+		REQUIRE(size == 5);
+	}
+
+	SECTION("Numbers bypass staging")
+	{
+		AsciiRecordingSink sink;
+		FormatStringWithReceiverAs<Encoding::CodePage::Utf16LittleEndian>(
+		    sink, CAFE_UTF8_SV("${}${:f.2}"), -123, 2.5);
+		REQUIRE(sink.Result == MakeView<Encoding::CodePage::Utf16LittleEndian>(u"-1232.50"));
+		REQUIRE(sink.AppendAsciiCount == 2);
+		REQUIRE(sink.ReserveCount == 0);
+
+		AsciiRecordingSink charsSink;
+		TranscodingSink<Encoding::CodePage::Utf8, AsciiRecordingSink> transcodingSink{ charsSink };
+		FormatStringWithCustomFormatter(transcodingSink, DefaultFormatter{},
+		                                CharsStringConverter{}, CAFE_UTF8_SV("${:x}"), 255);
+		transcodingSink.Finish();
+		REQUIRE(charsSink.Result == MakeView<Encoding::CodePage::Utf16LittleEndian>(u"ff"));
+		REQUIRE(charsSink.AppendAsciiCount == 1);
+		REQUIRE(charsSink.ReserveCount == 0);
+	}
+
+	SECTION("Code points across writes")
+	{
+		Encoding::String<Encoding::CodePage::Utf16LittleEndian> result;
+		StringSink resultSink{ result };
+		TranscodingSink<Encoding::CodePage::Utf8, decltype(resultSink)> sink{ resultSink };
+		const auto units = CAFE_UTF8_SV("a测𝄞").GetTrimmedSpan();
+		for (const auto unit : units)
+		{
+			sink(unit);
+		}
+		sink.Finish();
+		REQUIRE(result == MakeView<Encoding::CodePage::Utf16LittleEndian>(u"a测𝄞"));
+
+		sink.Append(units.first(2));
+		CHECK_THROWS_AS(sink.Finish(), EncodingFailedException);
+		const char8_t invalid[] = { u8'a', 0xFF, u8'b' };
+		CHECK_THROWS_AS(sink.Append(invalid), EncodingFailedException);
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format error policies", "[TextUtils][Format]")
+{
+	SECTION("Returning error codes")
+	{
+		STATIC_REQUIRE(noexcept(TryFormatString(CAFE_UTF8_SV("${}"), 1)));
+		STATIC_REQUIRE(!noexcept(FormatString(CAFE_UTF8_SV("${}"), 1)));
+
+		const auto result = TryFormatString(CAFE_UTF8_SV("${0}, ${1}, ${3:x}, ${2}, $$"), 1, 2.5f,
+		                                    -3, 18);
+		REQUIRE(result);
+		REQUIRE(result.Result == CAFE_UTF8_SV("1, 2.5, 12, -3, $"));
+
+		const auto errorCodeOf = [](auto const& format, auto const&... args) {
+			return TryFormatString(format, args...).ErrorCode;
+		};
+		CHECK(errorCodeOf(CAFE_UTF8_SV("${:q}"), 1) == FormatErrorCode::InvalidOption);
+		CHECK(errorCodeOf(CAFE_UTF8_SV("${:xb}"), 1) == FormatErrorCode::BaseRespecified);
+		CHECK(errorCodeOf(CAFE_UTF8_SV("${:f.999}"), 1.0) == FormatErrorCode::PrecisionTooLarge);
+		CHECK(errorCodeOf(CAFE_UTF8_SV("${0}${}"), 1) == FormatErrorCode::InvalidFormatString);
+		CHECK(errorCodeOf(CAFE_UTF8_SV("${"), 1) == FormatErrorCode::InvalidFormatString);
+		CHECK(errorCodeOf(CAFE_UTF8_SV("${5}"), 1) == FormatErrorCode::IndexOutOfRange);
+
+		// 出错前的结果已经写出
+		const auto partialResult = TryFormatString(CAFE_UTF8_SV("ab${}${:q}cd"), 1, 2);
+		REQUIRE(partialResult.ErrorCode == FormatErrorCode::InvalidOption);
+		REQUIRE(partialResult.Result == CAFE_UTF8_SV("ab1"));
+	}
+
+	SECTION("Prepared formats")
+	{
+		std::array<char8_t, 16> buffer;
+		const auto result = TryFormatTo(buffer, CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${:X}!")), 255);
+		REQUIRE(result);
+		REQUIRE(result.Result.WrittenSize == 3);
+
+		const FormatTemplate formatTemplate{ CAFE_UTF8_SV("${} ${:q}") };
+		REQUIRE(TryFormatString(formatTemplate, 1, 2).ErrorCode == FormatErrorCode::InvalidOption);
+		REQUIRE(TryFormatString(formatTemplate, 1).ErrorCode == FormatErrorCode::IndexOutOfRange);
+	}
+
+	SECTION("Assuming valid input")
+	{
+		const auto result =
+		    TryFormatString<AssumeValidFormatPolicy>(CAFE_UTF8_SV("${:xx} ${:f.999}"), 255, 0.5);
+		REQUIRE(result);
+		// "ff 0." 之后为限制到 MaxPrecision 的小数部分
+		REQUIRE(result.Result.GetView().GetTrimmedSpan().size() ==
+		        5 + FloatingFormatOption::MaxPrecision);
+
+		// 索引越界仍然会被检查
+		REQUIRE(TryFormatString<AssumeValidFormatPolicy>(CAFE_UTF8_SV("${1}"), 1).ErrorCode ==
+		        FormatErrorCode::IndexOutOfRange);
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format ranges", "[TextUtils][Format]")
+{
+	const std::vector<int> ids{ 1, 255, -16 };
+
+	SECTION("Separators and element options")
+	{
+		REQUIRE(FormatString(CAFE_UTF8_SV("[${}]"), ids) == CAFE_UTF8_SV("[1, 255, -16]"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("[${:x;sep=|}]"), ids) == CAFE_UTF8_SV("[1|ff|-10]"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${:;sep=}"), ids) == CAFE_UTF8_SV("1255-16"));
+		REQUIRE(FormatString(CAFE_UTF8_SV("${:X;sep=, }"), std::vector<int>{}) ==
+		        CAFE_UTF8_SV(""));
+		REQUIRE(FormatString(CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${:f.1;sep= / }")),
+		                     std::array{ 0.25, 1.0 }) == CAFE_UTF8_SV("0.2 / 1.0"));
+		REQUIRE(
+		    FormatString(MakeView<Encoding::CodePage::Utf16LittleEndian>(u"${:x;sep=、}"), ids) ==
+		    MakeView<Encoding::CodePage::Utf16LittleEndian>(u"1、ff、-10"));
+	}
+
+	SECTION("Nested and lazy ranges")
+	{
+		const std::vector<std::vector<int>> nested{ { 1, 2 }, {}, { 3 } };
+		REQUIRE(FormatString(CAFE_UTF8_SV("${}"), nested) == CAFE_UTF8_SV("1, 2, , 3"));
+
+		const std::vector<Encoding::StringView<Encoding::CodePage::Utf8>> names{
+			CAFE_UTF8_SV("甲"), CAFE_UTF8_SV("乙")
+		};
+		REQUIRE(FormatString(CAFE_UTF8_SV("${:;sep=、}"), names) == CAFE_UTF8_SV("甲、乙"));
+
+		const auto digits =
+		    std::views::iota(1, 100001) | std::views::transform([](int i) { return i % 7; });
+		std::size_t size{};
+		FormatStringWithReceiver([&](auto const& units) { size += units.size(); },
+		                         CAFE_UTF8_SV("${:;sep=}"), digits);
+		REQUIRE(size == 100000);
+	}
+
+	SECTION("Errors")
+	{
+		CHECK_THROWS_AS(FormatString(CAFE_UTF8_SV("${:q}"), ids), FormatException);
+		CHECK_THROWS_AS(FormatString(CAFE_UTF8_SV("${:x;sp=|}"), ids), FormatException);
+		REQUIRE(TryFormatString(CAFE_UTF8_SV("${:x;}"), ids).ErrorCode ==
+		        FormatErrorCode::InvalidOption);
+		const FormatTemplate rangeTemplate{ CAFE_UTF8_SV("${:x;sep=|}") };
+		REQUIRE_NOTHROW((rangeTemplate.Check<DefaultStringConverter, std::vector<int>>()));
+		CHECK_THROWS_AS((rangeTemplate.Check<DefaultStringConverter, std::vector<double>>()),
+		                FormatException);
+	}
+}
+
+TEST_CASE("Cafe.TextUtils.Format batch", "[TextUtils][Format]")
+{
+	std::vector<std::tuple<int, double, Encoding::StringView<Encoding::CodePage::Utf8>>> rows;
+	const Encoding::StringView<Encoding::CodePage::Utf8> names[] = { CAFE_UTF8_SV("偶数"),
+		                                                              CAFE_UTF8_SV("odd") };
+	for (int i = 0; i < 5000; ++i)
+	{
+		rows.emplace_back(i, i / 7.0, names[i % 2]);
+	}
+
+	constexpr auto format = CAFE_COMPILE_FORMAT(CAFE_UTF8_SV("${}\t${:f.3}\t${}\n"));
+	Encoding::String<Encoding::CodePage::Utf8> expected;
+	for (auto const& [index, value, name] : rows)
+	{
+		FormatStringWithReceiver(StringSink{ expected }, format, index, value, name);
+	}
+
+	SECTION("Same output as serial formatting")
+	{
+		for (const auto& [threadCount, chunkSize] :
+		     { std::pair{ 0, 1024 }, std::pair{ 1, 100 }, std::pair{ 4, 1 }, std::pair{ 3, 333 },
+		       std::pair{ 8, 100000 } })
+		{
+			Encoding::String<Encoding::CodePage::Utf8> result;
+			FormatBatch(
+			    format, rows, StringSink{ result },
+			    { static_cast<std::size_t>(threadCount), static_cast<std::size_t>(chunkSize) });
+			REQUIRE(result == expected);
+		}
+
+		std::size_t emptySize{};
+		FormatBatch(format, std::vector<std::tuple<int, double, int>>{},
+		            [&](auto const& units) { emptySize += units.size(); });
+		REQUIRE(emptySize == 0);
+	}
+
+	SECTION("Exceptions")
+	{
+		const FormatTemplate invalidFormat{ CAFE_UTF8_SV("${0} ${1:x}") };
+		Encoding::String<Encoding::CodePage::Utf8> result;
+		CHECK_THROWS_AS(FormatBatch(invalidFormat, rows, StringSink{ result }, { 4, 16 }),
+		                FormatException);
 	}
 }
@@ -1,10 +1,57 @@
+#include <Cafe/TextUtils/ArenaAllocator.h>
 #include <Cafe/TextUtils/CodePointIterator.h>
+#include <Cafe/TextUtils/ParallelEncode.h>
+#include <Cafe/TextUtils/Transcoder.h>
 #include <catch2/catch_all.hpp>
 #include <cstring>
+#include <random>
+#include <vector>
 
 using namespace Cafe;
 using namespace TextUtils;
 
+namespace
+{
+	// 逐码点转换，作为快速路径的参照
+	template <Encoding::CodePage::CodePageType ToCodePage,
+	          Encoding::CodePage::CodePageType FromCodePage>
+	Encoding::String<ToCodePage> ReferenceEncodeTo(Encoding::StringView<FromCodePage> str)
+	{
+		Encoding::String<ToCodePage> result;
+		str = str.Trim();
+		while (!str.IsEmpty())
+		{
+			Encoding::Encoder<FromCodePage, ToCodePage>::EncodeAll(str, [&](auto const& r) {
+				if constexpr (Encoding::GetEncodingResultCode<decltype(r)> ==
+				              Encoding::EncodingResultCode::Accept)
+				{
+					str = str.SubStr(r.AdvanceCount);
+					result.Append(r.Result);
+				}
+				else
+				{
+					str = str.SubStr(1);
+					Encoding::CodePage::CodePageTrait<ToCodePage>::FromCodePoint(
+					    0xFFFD, [&](auto const& r) {
+						    if constexpr (Encoding::GetEncodingResultCode<decltype(r)> ==
+						                  Encoding::EncodingResultCode::Accept)
+						    {
+							    result.Append(r.Result);
+						    }
+					    });
+				}
+			});
+		}
+		return result;
+	}
+
+	template <Encoding::CodePage::CodePageType CodePageValue, typename CharType>
+	Encoding::StringView<CodePageValue> ToView(std::vector<CharType> const& str)
+	{
+		return std::span<const CharType>(str);
+	}
+} // namespace
+
 TEST_CASE("Cafe.TextUtils.Misc", "[TextUtils][Misc]")
 {
 	SECTION("CodePointIterator")
@@ -29,4 +76,368 @@ TEST_CASE("Cafe.TextUtils.Misc", "[TextUtils][Misc]")
 		CHECK(codePointString[1] == 0x8BD5);
 		CHECK(codePointString[2] == 0);
 	}
+
+	SECTION("Arena")
+	{
+		alignas(std::max_align_t) std::byte buffer[64];
+		Arena arena{ buffer, 32 };
+
+		const auto first = arena.Allocate(3, 1);
+		const auto second = arena.Allocate(8, 8);
+		CHECK(first == buffer);
+		CHECK(reinterpret_cast<std::uintptr_t>(second) % 8 == 0);
+		CHECK(static_cast<std::byte*>(second) < buffer + 64);
+		CHECK(arena.GetChunkCount() == 0);
+
+		// 超出缓冲区及块大小的分配
+		arena.Allocate(100, 1);
+		CHECK(arena.GetChunkCount() == 1);
+
+		arena.Reset();
+		CHECK(arena.GetChunkCount() == 0);
+		CHECK(arena.Allocate(1, 1) == buffer);
+
+		const auto codePointString = EncodeTo<Encoding::CodePage::CodePoint>(
+		    CAFE_UTF8_SV("测试"), ArenaAllocator<std::byte>{ arena });
+		REQUIRE(codePointString.GetSize() == 3);
+		CHECK(codePointString[0] == 0x6D4B);
+		CHECK(codePointString[1] == 0x8BD5);
+		CHECK(codePointString.GetAllocator().GetArena() == &arena);
+	}
+
+	SECTION("Fast transcoding")
+	{
+		// 足够长以覆盖向量化的 ASCII 路径及分块的边界
+		std::vector<char8_t> ascii(5000);
+		for (std::size_t i = 0; i < ascii.size(); ++i)
+		{
+			ascii[i] = static_cast<char8_t>(0x20 + i % 0x5F);
+		}
+		const auto asciiView = ToView<Encoding::CodePage::Utf8>(ascii);
+		const auto utf16 = EncodeTo<Encoding::CodePage::Utf16LittleEndian>(asciiView);
+		const auto utf32 = EncodeTo<Encoding::CodePage::Utf32LittleEndian>(asciiView);
+		REQUIRE(utf16.GetSize() == ascii.size() + 1);
+		REQUIRE(utf32.GetSize() == ascii.size() + 1);
+		CHECK(utf16[4999] == ascii[4999]);
+		CHECK(utf32[1234] == ascii[1234]);
+		CHECK(EncodeTo<Encoding::CodePage::Utf8>(utf16.GetView()) == asciiView);
+		CHECK(EncodeTo<Encoding::CodePage::Utf8>(utf32.GetView()) == asciiView);
+
+		constexpr auto mixed = CAFE_UTF8_SV("ASCII 前缀，然后是中文与 emoji 😀🎉，最后 ASCII 结尾");
+		const auto mixed16 = EncodeTo<Encoding::CodePage::Utf16LittleEndian>(mixed);
+		CHECK(mixed16 == ReferenceEncodeTo<Encoding::CodePage::Utf16LittleEndian>(
+		                     Encoding::StringView<Encoding::CodePage::Utf8>{ mixed.Trim() }));
+		CHECK(EncodeTo<Encoding::CodePage::Utf8>(mixed16.GetView()) == mixed);
+		CHECK(EncodeTo<Encoding::CodePage::Utf8>(
+		          EncodeTo<Encoding::CodePage::CodePoint>(mixed).GetView()) == mixed);
+
+		// 过长编码、代理码点、超出范围及被截断的序列
+		for (const auto invalid :
+		     { CAFE_UTF8_SV("a\xC0\x80" "b").Trim(), CAFE_UTF8_SV("a\xE0\x80\x80" "b").Trim(),
+		       CAFE_UTF8_SV("a\xED\xA0\x80" "b").Trim(),
+		       CAFE_UTF8_SV("a\xF4\x90\x80\x80" "b").Trim(), CAFE_UTF8_SV("a\xE6\xB5").Trim() })
+		{
+			CHECK_THROWS_AS(EncodeTo<Encoding::CodePage::Utf16LittleEndian>(invalid),
+			                EncodingFailedException);
+			CHECK(EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(invalid) ==
+			      ReferenceEncodeTo<Encoding::CodePage::Utf16LittleEndian>(invalid));
+		}
+		CHECK(EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+		          CAFE_UTF8_SV("a\xC0\x80" "b")) == CAFE_UTF16_SV("a\uFFFD\uFFFDb"));
+		CHECK_THROWS_AS(EncodeTo<Encoding::CodePage::Utf8>(CAFE_UTF16_SV("a\xDC00")),
+		                EncodingFailedException);
+
+		// 随机输入的转换结果须与逐码点转换一致
+		std::mt19937 random{ 42 };
+		constexpr char8_t fragments[][4] = { { u8'a' }, { 0xC3, 0xA9 }, { 0xE6, 0xB5, 0x8B },
+			                                 { 0xF0, 0x9F, 0x98, 0x80 }, { 0x80 }, { 0xC0 },
+			                                 { 0xED, 0xA0, 0x80 }, { 0xF4, 0x90 } };
+		for (std::size_t round = 0; round < 200; ++round)
+		{
+			std::vector<char8_t> input;
+			const auto length = random() % 600;
+			for (std::size_t i = 0; i < length; ++i)
+			{
+				// 偏向 ASCII 以产生较长的 ASCII 块
+				const auto& fragment =
+				    fragments[random() % 4 ? 0 : random() % std::size(fragments)];
+				for (const auto unit : fragment)
+				{
+					if (unit)
+					{
+						input.push_back(unit);
+					}
+				}
+			}
+
+			const auto view = ToView<Encoding::CodePage::Utf8>(input);
+			const auto result16 =
+			    EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(view);
+			REQUIRE(result16 == ReferenceEncodeTo<Encoding::CodePage::Utf16LittleEndian>(view));
+			REQUIRE(EncodeToWithReplacement<Encoding::CodePage::CodePoint>(view) ==
+			        ReferenceEncodeTo<Encoding::CodePage::CodePoint>(view));
+			REQUIRE(EncodeTo<Encoding::CodePage::Utf8>(result16.GetView()) ==
+			        ReferenceEncodeTo<Encoding::CodePage::Utf8>(result16.GetView()));
+		}
+	}
+
+	SECTION("EncodedLength")
+	{
+		constexpr auto text = CAFE_UTF8_SV("ASCII 与中文及 emoji 😀，足够长以覆盖向量化的计数路径");
+		const auto utf16 = EncodeTo<Encoding::CodePage::Utf16LittleEndian>(text);
+		const auto utf32 = EncodeTo<Encoding::CodePage::Utf32LittleEndian>(text);
+
+		CHECK(EncodedLength<Encoding::CodePage::Utf8>(text) == text.GetSize() - 1);
+		CHECK(EncodedLength<Encoding::CodePage::Utf16LittleEndian>(text) == utf16.GetSize() - 1);
+		CHECK(EncodedLength<Encoding::CodePage::Utf32LittleEndian>(text) == utf32.GetSize() - 1);
+		CHECK(EncodedLength<Encoding::CodePage::Utf8>(utf16.GetView()) == text.GetSize() - 1);
+		CHECK(EncodedLength<Encoding::CodePage::Utf8>(utf32.GetView()) == text.GetSize() - 1);
+		// 无快速计数的编码对逐码点计数
+		CHECK(EncodedLength<Encoding::CodePage::Utf32LittleEndian>(utf16.GetView()) ==
+		      utf32.GetSize() - 1);
+		CHECK(EncodedLength<Encoding::CodePage::Utf16LittleEndian>(utf32.GetView()) ==
+		      utf16.GetSize() - 1);
+	}
+
+#if __has_include(<Cafe/Encoding/RuntimeEncoding.h>)
+	SECTION("Runtime encoding")
+	{
+		// 运行时编码的输入不去除结尾的空字符
+		const char8_t input[] = { u8'a', 0xE6, 0xB5, 0x8B, 0 };
+		const auto result = EncodeFromRuntime<Encoding::CodePage::Utf16LittleEndian>(
+		    Encoding::CodePage::Utf8, std::as_bytes(std::span(input)));
+		const char16_t expected[] = { u'a', u'测', 0 };
+		REQUIRE(std::ranges::equal(result.GetView().GetTrimmedSpan(), expected));
+		REQUIRE(std::ranges::equal(EncodeFromRuntime<Encoding::CodePage::Utf8>(
+		                               Encoding::CodePage::Utf8, std::as_bytes(std::span(input)))
+		                               .GetView()
+		                               .GetTrimmedSpan(),
+		                           input));
+
+		// 源编码与目标编码相同时直接复制，不校验输入
+		const char8_t invalid[] = { u8'a', 0xFF };
+		CHECK(std::ranges::equal(EncodeFromRuntime<Encoding::CodePage::Utf8>(
+		                             Encoding::CodePage::Utf8, std::as_bytes(std::span(invalid)))
+		                             .GetView()
+		                             .GetTrimmedSpan(),
+		                         invalid));
+	}
+#endif
+
+	SECTION("Replacement rules")
+	{
+		constexpr ReplacementOption perCodeUnit{ 0xFFFD, ReplacementRule::PerCodeUnit };
+		constexpr ReplacementOption maximalSubpart{};
+
+		CHECK(EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+		          CAFE_UTF8_SV("a\xE6\xB5" "b"), perCodeUnit) == CAFE_UTF16_SV("a\uFFFD\uFFFDb"));
+		CHECK(EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+		          CAFE_UTF8_SV("a\xE6\xB5" "b"), maximalSubpart) == CAFE_UTF16_SV("a\uFFFDb"));
+		// 首字节之后的编码单元超出允许的范围时，首字节单独作为最长子部分
+		CHECK(EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+		          CAFE_UTF8_SV("\xE0\x80\x80\xF0\x9F\x98"), maximalSubpart) ==
+		      CAFE_UTF16_SV("\uFFFD\uFFFD\uFFFD\uFFFD"));
+		CHECK(EncodeToWithReplacement<Encoding::CodePage::Utf8>(CAFE_UTF8_SV("测\xE8\xAF" "试"),
+		                                                        maximalSubpart) ==
+		      CAFE_UTF8_SV("测\uFFFD试"));
+
+		std::vector<std::pair<std::size_t, std::size_t>> errors;
+		const auto recordError = [&](std::size_t position, std::size_t length) {
+			errors.emplace_back(position, length);
+		};
+
+		// 超过分块大小的输入中，错误位置仍相对于整个输入
+		std::vector<char8_t> input(3000, u8'a');
+		input[1] = 0xE6;
+		input[2] = 0xB5;
+		input[2500] = 0xFF;
+		input[2999] = 0xF0;
+		const auto result = EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+		    ToView<Encoding::CodePage::Utf8>(input), maximalSubpart, recordError);
+		CHECK(result.GetSize() == 2999 + 1);
+		CHECK(errors == decltype(errors){ { 1, 2 }, { 2500, 1 }, { 2999, 1 } });
+
+		// 无快速路径的编码对
+		errors.clear();
+		CHECK(EncodeToWithReplacement<Encoding::CodePage::Utf32LittleEndian>(
+		          CAFE_UTF16_SV("a\xD800" "b\xDC00"), maximalSubpart, recordError) ==
+		      CAFE_UTF32_SV("a\uFFFDb\uFFFD"));
+		CHECK(errors == decltype(errors){ { 1, 1 }, { 3, 1 } });
+
+		// 快速路径与逐码点转换的结果须一致
+		std::mt19937 random{ 7 };
+		for (std::size_t round = 0; round < 100; ++round)
+		{
+			std::vector<char8_t> randomInput(random() % 2000);
+			for (auto& unit : randomInput)
+			{
+				unit = static_cast<char8_t>(random() % 8 ? random() % 0x80 : random() % 0x100);
+			}
+
+			const auto view = ToView<Encoding::CodePage::Utf8>(randomInput);
+			std::vector<std::pair<std::size_t, std::size_t>> fastErrors;
+			const auto fastResult = EncodeToWithReplacement<Encoding::CodePage::CodePoint>(
+			    view, maximalSubpart, [&](std::size_t position, std::size_t length) {
+				    fastErrors.emplace_back(position, length);
+			    });
+			errors.clear();
+			const auto result = EncodeToWithReplacement<Encoding::CodePage::Utf8>(
+			    view, maximalSubpart, recordError);
+			REQUIRE(EncodeTo<Encoding::CodePage::Utf8>(fastResult.GetView()) == result);
+			REQUIRE(fastErrors == errors);
+		}
+	}
+
+	SECTION("Transcoder")
+	{
+		constexpr auto text = CAFE_UTF8_SV("分块输入的文本 with emoji 😀 跨越边界");
+		const auto input = text.GetTrimmedSpan();
+
+		// 逐字节输入
+		{
+			Transcoder<Encoding::CodePage::Utf8, Encoding::CodePage::Utf16LittleEndian> transcoder;
+			Encoding::String<Encoding::CodePage::Utf16LittleEndian> result;
+			for (std::size_t i = 0; i < input.size(); ++i)
+			{
+				transcoder.Feed(input.subspan(i, 1), result);
+			}
+			transcoder.Finish(result);
+			CHECK(result == EncodeTo<Encoding::CodePage::Utf16LittleEndian>(text));
+		}
+
+		// 随机分块的含无效序列的输入，结果须与一次性转换相同
+		std::mt19937 random{ 3 };
+		for (std::size_t round = 0; round < 100; ++round)
+		{
+			std::vector<char8_t> randomInput(random() % 3000);
+			for (auto& unit : randomInput)
+			{
+				// 不产生 0，避免结尾的 0 被视为空字符截去
+				unit = static_cast<char8_t>(random() % 4 ? random() % 0x7F + 1
+				                                         : random() % 0xFF + 1);
+			}
+
+			Transcoder<Encoding::CodePage::Utf8, Encoding::CodePage::Utf16LittleEndian,
+			           ReturnReplacementPolicy<>>
+			    transcoder;
+			Encoding::String<Encoding::CodePage::Utf16LittleEndian> result;
+			std::span<const char8_t> rest = randomInput;
+			while (!rest.empty())
+			{
+				const auto size = std::min<std::size_t>(rest.size(), random() % 8);
+				transcoder.Feed(rest.first(size), result);
+				rest = rest.subspan(size);
+			}
+			transcoder.Finish(result);
+			REQUIRE(result ==
+			        EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+			            ToView<Encoding::CodePage::Utf8>(randomInput), ReplacementOption{}));
+		}
+
+		// 结尾不完整的码点
+		{
+			Transcoder<Encoding::CodePage::Utf8, Encoding::CodePage::Utf16LittleEndian> transcoder;
+			Encoding::String<Encoding::CodePage::Utf16LittleEndian> result;
+			transcoder.Feed(CAFE_UTF8_SV("a\xF0\x9F"), result);
+			CHECK(transcoder.GetPendingSize() == 2);
+			CHECK_THROWS_AS(transcoder.Finish(result), EncodingFailedException);
+			CHECK(transcoder.GetPendingSize() == 0);
+			CHECK(result == CAFE_UTF16_SV("a"));
+		}
+
+		// 无快速路径的编码对，代理对跨越边界
+		{
+			Transcoder<Encoding::CodePage::Utf16LittleEndian, Encoding::CodePage::Utf32LittleEndian,
+			           ReturnReplacementPolicy<>>
+			    transcoder;
+			Encoding::String<Encoding::CodePage::Utf32LittleEndian> result;
+			transcoder.Feed(CAFE_UTF16_SV("a\xD83D"), result);
+			transcoder.Feed(CAFE_UTF16_SV("\xDE00" "b\xD83D"), result);
+			transcoder.Finish(result);
+			CHECK(result == CAFE_UTF32_SV("a\U0001F600b\uFFFD"));
+		}
+	}
+
+	SECTION("Parallel encoding")
+	{
+		// 使块边界落在多字节序列及代理对的中间
+		constexpr ParallelEncodeOption option{ 4, 100 };
+
+		Encoding::String<Encoding::CodePage::Utf8> text;
+		for (std::size_t i = 0; i < 300; ++i)
+		{
+			text.Append(CAFE_UTF8_SV("并行转换 parallel 😀"));
+		}
+		const auto utf16 = EncodeTo<Encoding::CodePage::Utf16LittleEndian>(text.GetView());
+		CHECK(EncodeToParallel<Encoding::CodePage::Utf16LittleEndian>(text.GetView(), option) ==
+		      utf16);
+		CHECK(EncodeToParallel<Encoding::CodePage::Utf8>(utf16.GetView(), option) == text);
+		CHECK(EncodeToParallel<Encoding::CodePage::Utf32LittleEndian>(utf16.GetView(), option) ==
+		      EncodeTo<Encoding::CodePage::Utf32LittleEndian>(utf16.GetView()));
+
+		std::vector<char8_t> invalidText(text.GetView().GetTrimmedSpan().begin(),
+		                                 text.GetView().GetTrimmedSpan().end());
+		invalidText[invalidText.size() / 2] = 0xFF;
+		CHECK_THROWS_AS(EncodeToParallel<Encoding::CodePage::Utf16LittleEndian>(
+		                    ToView<Encoding::CodePage::Utf8>(invalidText), option),
+		                EncodingFailedException);
+
+		// 各块直接写入结果，无效的输入不能使其越过所属的部分
+		std::vector<char16_t> invalidUtf16(utf16.GetView().GetTrimmedSpan().begin(),
+		                                   utf16.GetView().GetTrimmedSpan().end());
+		invalidUtf16[invalidUtf16.size() / 3] = 0xD800;
+		invalidUtf16[invalidUtf16.size() / 3 + 1] = u'a';
+		const auto invalidUtf16View = ToView<Encoding::CodePage::Utf16LittleEndian>(invalidUtf16);
+		CHECK_THROWS_AS(EncodeToParallel<Encoding::CodePage::Utf8>(invalidUtf16View, option),
+		                EncodingFailedException);
+		CHECK_THROWS_AS(
+		    EncodeToParallel<Encoding::CodePage::Utf32LittleEndian>(invalidUtf16View, option),
+		    EncodingFailedException);
+		CHECK(EncodeToWithReplacementParallel<Encoding::CodePage::Utf8>(
+		          invalidUtf16View, { 0xFFFD, ReplacementRule::PerCodeUnit }, option) ==
+		      EncodeToWithReplacement<Encoding::CodePage::Utf8>(invalidUtf16View));
+
+		// 含无效序列的输入，结果及错误位置须与串行转换相同
+		std::mt19937 random{ 5 };
+		for (std::size_t round = 0; round < 50; ++round)
+		{
+			std::vector<char8_t> randomInput(random() % 5000);
+			for (auto& unit : randomInput)
+			{
+				unit = static_cast<char8_t>(random() % 4 ? random() % 0x80 : random() % 0x100);
+			}
+			const auto view = ToView<Encoding::CodePage::Utf8>(randomInput);
+
+			for (const auto rule :
+			     { ReplacementRule::PerCodeUnit, ReplacementRule::MaximalSubpart })
+			{
+				std::vector<std::pair<std::size_t, std::size_t>> errors;
+				std::vector<std::pair<std::size_t, std::size_t>> parallelErrors;
+				const auto result = EncodeToWithReplacement<Encoding::CodePage::Utf16LittleEndian>(
+				    view, { 0xFFFD, rule }, [&](std::size_t position, std::size_t length) {
+					    errors.emplace_back(position, length);
+				    });
+				const auto parallelResult =
+				    EncodeToWithReplacementParallel<Encoding::CodePage::Utf16LittleEndian>(
+				        view, { 0xFFFD, rule }, option,
+				        [&](std::size_t position, std::size_t length) {
+					        parallelErrors.emplace_back(position, length);
+				        });
+				REQUIRE(parallelResult == result);
+				REQUIRE(parallelErrors == errors);
+			}
+		}
+
+		// 块很小时边界可能前移至输入的开头
+		const auto shortText = CAFE_UTF8_SV("中文");
+		const auto shortUtf16 = EncodeTo<Encoding::CodePage::Utf16LittleEndian>(shortText);
+		for (std::size_t minChunkSize = 1; minChunkSize <= 3; ++minChunkSize)
+		{
+			const ParallelEncodeOption shortOption{ 4, minChunkSize };
+			CHECK(EncodeToParallel<Encoding::CodePage::Utf16LittleEndian>(shortText, shortOption) ==
+			      shortUtf16);
+			CHECK(EncodeToWithReplacementParallel<Encoding::CodePage::Utf16LittleEndian>(
+			          shortText, ReplacementOption{}, shortOption) == shortUtf16);
+		}
+	}
 }
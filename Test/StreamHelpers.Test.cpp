@@ -1,4 +1,5 @@
 #include <Cafe/Io/Streams/MemoryStream.h>
+#include <Cafe/TextUtils/ArenaAllocator.h>
 #include <Cafe/TextUtils/TextReader.h>
 #include <Cafe/TextUtils/TextWriter.h>
 #include <catch2/catch_all.hpp>
@@ -44,5 +45,30 @@ TEST_CASE("Cafe.TextUtils.StreamHelpers", "[TextUtils][StreamHelpers]")
 #endif
 
 		REQUIRE(line == TestString);
+
+		stream.SeekFromBegin(0);
+
+		Arena arena;
+		TextReader<CodePage::Utf8> arenaReader{ &stream };
+		const auto arenaLine = arenaReader.ReadLine(ArenaAllocator<char8_t>{ arena });
+		REQUIRE(arenaLine.GetView() == TestString);
+		REQUIRE(arena.GetChunkCount() == 1);
+	}
+
+	SECTION("Formatted writing")
+	{
+		MemoryStream stream;
+		TextWriter<CodePage::Utf8> writer{ &stream, 8 };
+		const auto writtenBytes =
+		    writer.Write(CAFE_UTF8_SV("${}: ${:x} ${} $$"), 42, 255, CAFE_UTF8_SV("测试"));
+		writer.Flush();
+
+		constexpr auto Expected = CAFE_UTF8_SV("42: ff 测试 $");
+		REQUIRE(writtenBytes == Expected.GetSize() - 1);
+		REQUIRE(stream.GetPosition() == Expected.GetSize() - 1);
+
+		const auto internalStorage = stream.GetInternalStorage();
+		REQUIRE(std::memcmp(internalStorage.data(), Expected.GetData(), Expected.GetSize() - 1) ==
+		        0);
 	}
 }
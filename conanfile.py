@@ -7,7 +7,8 @@ Options = [
     # Cafe.TextUtils
     ("CAFE_INCLUDE_TEXT_UTILS_MISC", [True, False], True),
     ("CAFE_INCLUDE_TEXT_UTILS_FORMAT", [True, False], True),
-    ("CAFE_INCLUDE_TEXT_UTILS_STREAM_HELPERS", [True, False], True)
+    ("CAFE_INCLUDE_TEXT_UTILS_STREAM_HELPERS", [True, False], True),
+    ("CAFE_INCLUDE_BENCHMARKS", [True, False], False)
 ]
 
 
@@ -28,10 +29,10 @@ class CafeTextUtilsConan(ConanFile):
 
     generators = "cmake"
 
-    exports_sources = "CMakeLists.txt", "CafeCommon*", "Format*", "Misc*", "StreamHelpers*", "Test*"
+    exports_sources = "CMakeLists.txt", "CafeCommon*", "Format*", "Misc*", "StreamHelpers*", "Test*", "Benchmark*"
 
     def requirements(self):
-        if self.options.CAFE_INCLUDE_TESTS:
+        if self.options.CAFE_INCLUDE_TESTS or self.options.CAFE_INCLUDE_BENCHMARKS:
             self.requires("catch2/3.2.0", private=True)
         if self.options.CAFE_INCLUDE_TEXT_UTILS_STREAM_HELPERS:
             self.requires("Cafe.Io/0.1")